@@ -0,0 +1,62 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_ALIGNEDALLOCATOR_HPP_
+#define SRC_QPIDIT_ALIGNEDALLOCATOR_HPP_
+
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+namespace qpidit
+{
+
+    // Allocator that honours alignof(T). Before C++17, std::allocator only guarantees the alignment of
+    // operator new, so a std::vector of a type declared alignas(64) needs this to keep its elements on
+    // their own cache lines.
+    template<typename T> class AlignedAllocator
+    {
+    public:
+        typedef T value_type;
+
+        AlignedAllocator() {}
+        template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+        T* allocate(std::size_t n) {
+            const std::size_t alignment = alignof(T) < sizeof(void*) ? sizeof(void*) : alignof(T);
+            void* p = 0;
+            if (n > std::size_t(-1) / sizeof(T) || ::posix_memalign(&p, alignment, n * sizeof(T)) != 0) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t) {
+            ::free(p);
+        }
+    };
+
+    template<typename T, typename U> bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+    template<typename T, typename U> bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_ALIGNEDALLOCATOR_HPP_ */
@@ -0,0 +1,297 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/AllocTracker.hpp"
+
+#include <atomic>
+#include <stdint.h>
+
+#ifdef QPIDIT_ALLOC_TRACKING
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// glibc's own allocator, which the replacements below count and forward to
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t num, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+}
+
+#endif
+
+namespace
+{
+    std::atomic<int> s_phase;
+
+#ifdef QPIDIT_ALLOC_TRACKING
+
+    // Counts of one thread, or of every thread past the first s_maxThreads - 1, which share the last.
+    // Counters only need to be atomic, not ordered between threads: the owning thread of an unshared
+    // counter updates it with a plain load and store, as nothing else writes it.
+    struct alignas(64) ThreadCounters
+    {
+        std::atomic<uint64_t> mallocCalls[qpidit::AllocTracker::NUM_PHASES];
+        std::atomic<uint64_t> mallocBytes[qpidit::AllocTracker::NUM_PHASES]; // Usable size of the blocks allocated
+        int64_t unflushedLiveBytes; // Not yet added to s_liveBytes, unused when shared
+    };
+
+    const int s_maxThreads = 256;
+    const int64_t s_liveBytesFlushSize = 256 * 1024;
+
+    // Zero-initialized before any constructor runs, so that allocations by static initializers are counted.
+    // A static array honours alignas, so no two threads' counters share a cache line.
+    ThreadCounters s_threadCounters[s_maxThreads];
+    ThreadCounters& s_sharedCounters = s_threadCounters[s_maxThreads - 1];
+    std::atomic<int> s_numThreads;
+    std::atomic<int64_t> s_liveBytes;
+    std::atomic<uint64_t> s_peakLiveBytes[qpidit::AllocTracker::NUM_PHASES];
+
+    // Plain pointer, so that the thread_local needs no constructor or destructor, which could allocate
+    thread_local ThreadCounters* t_counters;
+
+    ThreadCounters& threadCounters() {
+        if (t_counters == 0) {
+            const int thread = s_numThreads.fetch_add(1, std::memory_order_relaxed);
+            t_counters = thread < s_maxThreads - 1 ? &s_threadCounters[thread] : &s_sharedCounters;
+        }
+        return *t_counters;
+    }
+
+    void addCount(ThreadCounters& counters, std::atomic<uint64_t>& counter, uint64_t n) {
+        if (&counters == &s_sharedCounters) {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        } else {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+
+    void raisePeak(std::atomic<uint64_t>& peakLiveBytes, int64_t liveBytes) {
+        if (liveBytes <= 0) return;
+        uint64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+        while (uint64_t(liveBytes) > peak &&
+               !peakLiveBytes.compare_exchange_weak(peak, liveBytes, std::memory_order_relaxed)) {}
+    }
+
+    void flushLiveBytes(int64_t liveBytesChange) {
+        const int64_t liveBytes = s_liveBytes.fetch_add(liveBytesChange, std::memory_order_relaxed) + liveBytesChange;
+        if (liveBytesChange > 0) {
+            raisePeak(s_peakLiveBytes[s_phase.load(std::memory_order_relaxed)], liveBytes);
+        }
+    }
+
+    void addLiveBytes(ThreadCounters& counters, int64_t liveBytesChange) {
+        if (&counters == &s_sharedCounters) {
+            flushLiveBytes(liveBytesChange);
+            return;
+        }
+        counters.unflushedLiveBytes += liveBytesChange;
+        if (counters.unflushedLiveBytes >= s_liveBytesFlushSize || counters.unflushedLiveBytes <= -s_liveBytesFlushSize) {
+            flushLiveBytes(counters.unflushedLiveBytes);
+            counters.unflushedLiveBytes = 0;
+        }
+    }
+
+    void* recordAlloc(void* ptr) {
+        if (ptr != 0) {
+            const uint64_t size = ::malloc_usable_size(ptr);
+            const int phase = s_phase.load(std::memory_order_relaxed);
+            ThreadCounters& counters = threadCounters();
+            addCount(counters, counters.mallocCalls[phase], 1);
+            addCount(counters, counters.mallocBytes[phase], size);
+            addLiveBytes(counters, size);
+        }
+        return ptr;
+    }
+
+    void recordFree(uint64_t size) {
+        if (size > 0) {
+            addLiveBytes(threadCounters(), -int64_t(size));
+        }
+    }
+
+    uint64_t usableSize(void* ptr) {
+        return ptr == 0 ? 0 : ::malloc_usable_size(ptr);
+    }
+
+    void* alignedAlloc(size_t alignment, size_t size) {
+        return recordAlloc(__libc_memalign(alignment, size));
+    }
+
+    struct PhaseTotals
+    {
+        uint64_t mallocCalls;
+        uint64_t mallocBytes;
+        uint64_t peakLiveBytes;
+    };
+
+    // Sums the counts of every thread which has allocated
+    PhaseTotals phaseTotals(int phase) {
+        PhaseTotals totals = {0, 0, s_peakLiveBytes[phase].load(std::memory_order_relaxed)};
+        const int numThreads = s_numThreads.load(std::memory_order_relaxed);
+        for (int i=0; i<numThreads && i<s_maxThreads; ++i) {
+            totals.mallocCalls += s_threadCounters[i].mallocCalls[phase].load(std::memory_order_relaxed);
+            totals.mallocBytes += s_threadCounters[i].mallocBytes[phase].load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+    // Appends the counts to the file named by QPIDIT_ALLOC_STATS as the shim exits. Written with stdio,
+    // as jsoncpp may already be torn down.
+    struct ExitReport
+    {
+        ~ExitReport() {
+            const char* fileName = ::getenv("QPIDIT_ALLOC_STATS");
+            if (fileName == 0 || *fileName == '\0') return;
+            FILE* f = ::fopen(fileName, "a");
+            if (f == 0) return;
+            ::fprintf(f, "{\"shim\":\"%s\",\"pid\":%d,\"alloc\":{", program_invocation_name, int(::getpid()));
+            for (int i=0; i<qpidit::AllocTracker::NUM_PHASES; ++i) {
+                const PhaseTotals totals = phaseTotals(i);
+                ::fprintf(f, "%s\"%s\":{\"mallocCalls\":%llu,\"mallocBytes\":%llu,\"peakLiveBytes\":%llu}",
+                          i == 0 ? "" : ",", qpidit::AllocTracker::s_phaseNames[i],
+                          (unsigned long long)totals.mallocCalls,
+                          (unsigned long long)totals.mallocBytes,
+                          (unsigned long long)totals.peakLiveBytes);
+            }
+            ::fprintf(f, "}}\n");
+            ::fclose(f);
+        }
+    } s_exitReport;
+
+#endif
+}
+
+#ifdef QPIDIT_ALLOC_TRACKING
+
+// Replacements for the glibc allocator, which take the place of its own for the shared libraries too
+
+extern "C" {
+
+    void* malloc(size_t size) noexcept {
+        return recordAlloc(__libc_malloc(size));
+    }
+
+    void* calloc(size_t num, size_t size) noexcept {
+        return recordAlloc(__libc_calloc(num, size));
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept {
+        const uint64_t oldSize = usableSize(ptr);
+        void* newPtr = __libc_realloc(ptr, size);
+        if (newPtr == 0 && size > 0) return 0; // ptr is left as it was
+        recordFree(oldSize);
+        return recordAlloc(newPtr);
+    }
+
+    void free(void* ptr) noexcept {
+        recordFree(usableSize(ptr));
+        __libc_free(ptr);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept {
+        return alignedAlloc(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept {
+        return alignedAlloc(alignment, size);
+    }
+
+    int posix_memalign(void** memptr, size_t alignment, size_t size) noexcept {
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+        void* ptr = alignedAlloc(alignment, size);
+        if (ptr == 0) return ENOMEM;
+        *memptr = ptr;
+        return 0;
+    }
+
+    void* valloc(size_t size) noexcept {
+        return alignedAlloc(::sysconf(_SC_PAGESIZE), size);
+    }
+
+    void* pvalloc(size_t size) noexcept {
+        const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+        return alignedAlloc(pageSize, (size + pageSize - 1) & ~(pageSize - 1));
+    }
+
+}
+
+#endif
+
+namespace qpidit
+{
+
+    // static
+    const char* const AllocTracker::s_phaseNames[NUM_PHASES] = {"startup", "connect", "transfer", "shutdown"};
+
+    // static
+    void AllocTracker::advancePhase(Phase phase) {
+        int current = s_phase.load(std::memory_order_relaxed);
+        while (current < phase) {
+            if (s_phase.compare_exchange_weak(current, phase, std::memory_order_relaxed)) {
+#ifdef QPIDIT_ALLOC_TRACKING
+                // The peak of a phase is at least what was live on entering it
+                raisePeak(s_peakLiveBytes[phase], s_liveBytes.load(std::memory_order_relaxed));
+#endif
+                return;
+            }
+        }
+    }
+
+    // static
+    AllocTracker::Phase AllocTracker::getPhase() {
+        return Phase(s_phase.load(std::memory_order_relaxed));
+    }
+
+    // static
+    bool AllocTracker::isEnabled() {
+#ifdef QPIDIT_ALLOC_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // static
+    // Null unless enabled
+    Json::Value AllocTracker::toJson() {
+#ifdef QPIDIT_ALLOC_TRACKING
+        Json::Value phases(Json::objectValue);
+        for (int i=0; i<NUM_PHASES; ++i) {
+            const PhaseTotals totals = phaseTotals(i);
+            Json::Value phase(Json::objectValue);
+            phase["mallocCalls"] = Json::UInt64(totals.mallocCalls);
+            phase["mallocBytes"] = Json::UInt64(totals.mallocBytes);
+            phase["peakLiveBytes"] = Json::UInt64(totals.peakLiveBytes);
+            phases[s_phaseNames[i]] = phase;
+        }
+        return phases;
+#else
+        return Json::Value();
+#endif
+    }
+
+} // namespace qpidit
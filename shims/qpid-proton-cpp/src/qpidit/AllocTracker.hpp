@@ -0,0 +1,67 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_ALLOCTRACKER_HPP_
+#define SRC_QPIDIT_ALLOCTRACKER_HPP_
+
+#include <json/value.h>
+
+namespace qpidit
+{
+
+    /*
+     * Counts the heap allocations of the whole process (proton, jsoncpp and shim code alike) by the phase
+     * of the shim's run in which they are made. When built with CMake option QPIDIT_ALLOC_TRACKING, a shim
+     * linking the AllocTracker library has malloc() and friends replaced by counting wrappers around glibc's
+     * own allocator. Otherwise only the phase is kept, and nothing is counted.
+     *
+     * Each thread counts in its own counters, which are summed when reported, so that threads allocating
+     * at once do not contend for shared cache lines. Live bytes reach the shared total (and so the peaks)
+     * in steps of up to 256KiB per thread, so peakLiveBytes may be short by that much per allocating thread.
+     *
+     * If environment variable QPIDIT_ALLOC_STATS names a file, one line of JSON with the counts is
+     * appended to it as the shim exits, for shims whose output has no room for them.
+     */
+    class AllocTracker
+    {
+    public:
+        // In run order, a shim only moves forward through these
+        enum Phase {STARTUP = 0,
+                    CONNECT,
+                    TRANSFER,
+                    SHUTDOWN,
+                    NUM_PHASES};
+        static const char* const s_phaseNames[NUM_PHASES];
+
+        // Move to phase, unless already in or past it. May be called from any thread.
+        static void advancePhase(Phase phase);
+        static Phase getPhase();
+
+        // False unless built with QPIDIT_ALLOC_TRACKING
+        static bool isEnabled();
+
+        // {"<phase name>": {"mallocCalls": N, "mallocBytes": N, "peakLiveBytes": N}, ...}
+        static Json::Value toJson();
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_ALLOCTRACKER_HPP_ */
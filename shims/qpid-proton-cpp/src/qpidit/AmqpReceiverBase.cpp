@@ -21,32 +21,91 @@
 
 #include "qpidit/AmqpReceiverBase.hpp"
 
-#include <sstream>
-#include <proton/connection_options.hpp>
-#include <proton/container.hpp>
+#include <proton/connection.hpp>
 #include <proton/receiver.hpp>
-#include <proton/reconnect_options.hpp>
+#include <proton/receiver_options.hpp>
 #include <proton/thread_safe.hpp> // for proton::returned<>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/QpidItErrors.hpp>
 
 namespace qpidit
 {
 
     AmqpReceiverBase::AmqpReceiverBase(const std::string& testName,
                                        const std::string& brokerAddr,
-                                       const std::string& queueName):
-                    AmqpTestBase(testName, brokerAddr, queueName)
-    {}
+                                       const std::string& queueName,
+                                       const ShimOptions& options):
+                    AmqpTestBase(testName, brokerAddr, queueName, options),
+                    _creditWindow(options.getUInt("credit-window", 0)),
+                    _creditLowWater(options.getUInt("credit-low-water", 0)),
+                    _ackBatch(getPositiveOption(options, "ack-batch")),
+                    _linkShards(getNumLinks())
+    {
+        if (options.hasOption("credit-low-water") && (_creditWindow == 0 || _creditLowWater >= _creditWindow)) {
+            throw qpidit::ArgumentError("Option \"--credit-low-water\" requires a larger \"--credit-window\"");
+        }
+        for (LinkShardList_t::iterator i=_linkShards.begin(); i!=_linkShards.end(); ++i) {
+            i->unacceptedDeliveries.reserve(_ackBatch);
+        }
+    }
 
     AmqpReceiverBase::~AmqpReceiverBase() {}
 
-    void AmqpReceiverBase::on_container_start(proton::container &c) {
-        std::ostringstream oss;
-        oss << _brokerAddr << "/" << _queueName;
-        proton::reconnect_options ro;
-        ro.max_attempts(2);
-        proton::connection_options co;
-        co.reconnect(ro);
-        c.open_receiver(oss.str(), co);
+    void AmqpReceiverBase::on_receiver_open(proton::receiver& r) {
+        AllocTracker::advancePhase(AllocTracker::TRANSFER);
+        // With manual credit the link opens with none, issue the whole window once
+        if (_creditLowWater > 0 && r.credit() == 0) {
+            r.add_credit(_creditWindow);
+        }
+    }
+
+    // protected
+
+    // By default proton issues credit_window credit and tops it up after every message, and accepts every
+    // message once on_message returns. Manual credit is issued in bulk at the low-water mark instead, and
+    // batched accepts are written out together, which the transport coalesces into ranged disposition frames.
+    void AmqpReceiverBase::openLink(proton::connection& c, uint32_t linkIndex) {
+        proton::receiver_options ro;
+        ro.name(getLinkName(linkIndex));
+        if (_creditLowWater > 0) {
+            ro.credit_window(0);
+        } else if (_creditWindow > 0) {
+            ro.credit_window(_creditWindow);
+        }
+        if (_ackBatch > 1) {
+            ro.auto_accept(false);
+        }
+        c.open_receiver(_queueName, ro);
+    }
+
+    // Accept any deliveries still waiting for a batch, they would otherwise be released by the close
+    void AmqpReceiverBase::closeConnection(uint32_t connectionIndex) {
+        for (uint32_t i=0; i<_linksPerConnection; ++i) {
+            acceptDeliveries(_linkShards[connectionIndex * _linksPerConnection + i]);
+        }
+        AmqpTestBase::closeConnection(connectionIndex);
+    }
+
+    void AmqpReceiverBase::messageProcessed(proton::delivery& d) {
+        proton::receiver r(d.receiver());
+        if (_ackBatch > 1) {
+            LinkShard& linkShard = _linkShards[getLinkIndex(r)];
+            linkShard.unacceptedDeliveries.push_back(d);
+            if (linkShard.unacceptedDeliveries.size() >= _ackBatch) {
+                acceptDeliveries(linkShard);
+            }
+        }
+        if (_creditLowWater > 0 && uint32_t(r.credit()) <= _creditLowWater) {
+            r.add_credit(_creditWindow - r.credit());
+        }
+    }
+
+    void AmqpReceiverBase::acceptDeliveries(LinkShard& linkShard) {
+        for (std::vector<proton::delivery>::iterator i=linkShard.unacceptedDeliveries.begin();
+             i!=linkShard.unacceptedDeliveries.end(); ++i) {
+            i->accept();
+        }
+        linkShard.unacceptedDeliveries.clear();
     }
 
 } // namespace qpidit
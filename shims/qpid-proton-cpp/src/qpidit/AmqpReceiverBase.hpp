@@ -22,7 +22,11 @@
 #ifndef SRC_QPIDIT_AMQPRECEIVERBASE_HPP_
 #define SRC_QPIDIT_AMQPRECEIVERBASE_HPP_
 
+#include <stdint.h>
+#include <vector>
+#include <proton/delivery.hpp>
 #include <proton/messaging_handler.hpp>
+#include <qpidit/AlignedAllocator.hpp>
 #include <qpidit/AmqpTestBase.hpp>
 
 namespace qpidit
@@ -30,13 +34,35 @@ namespace qpidit
 
     class AmqpReceiverBase : public AmqpTestBase
     {
+    protected:
+        // Deliveries of one link waiting for a batched accept, only accessed from its connection's handler thread
+        struct alignas(64) LinkShard
+        {
+            std::vector<proton::delivery> unacceptedDeliveries;
+        };
+        typedef std::vector<LinkShard, AlignedAllocator<LinkShard> > LinkShardList_t;
+
+        const uint32_t _creditWindow;   // --credit-window N: link credit (prefetch), 0 for the proton default
+        const uint32_t _creditLowWater; // --credit-low-water M: top credit back up to N once it falls to M
+        const uint32_t _ackBatch;       // --ack-batch B: accept deliveries B at a time
+        LinkShardList_t _linkShards;
+
     public:
         AmqpReceiverBase(const std::string& testName,
                          const std::string& brokerAddr,
-                         const std::string& queueName);
+                         const std::string& queueName,
+                         const ShimOptions& options = ShimOptions());
         virtual ~AmqpReceiverBase();
 
-        void on_container_start(proton::container &c);
+        void on_receiver_open(proton::receiver& r);
+
+    protected:
+        void openLink(proton::connection& c, uint32_t linkIndex);
+        void closeConnection(uint32_t connectionIndex);
+        // Called by subclasses from on_message once d has been processed: accepts d (now or in a batch)
+        // and replenishes manual credit
+        void messageProcessed(proton::delivery& d);
+        void acceptDeliveries(LinkShard& linkShard);
     };
 
 } // namespace qpidit
@@ -21,47 +21,226 @@
 
 #include "qpidit/AmqpSenderBase.hpp"
 
-#include <sstream>
-#include <proton/connection_options.hpp>
-#include <proton/container.hpp>
-#include <proton/reconnect_options.hpp>
+#include <algorithm>
+#include <proton/connection.hpp>
+#include <proton/sender.hpp>
+#include <proton/sender_options.hpp>
 #include <proton/thread_safe.hpp>
 #include <proton/tracker.hpp>
+#include <proton/work_queue.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/PerfStats.hpp>
+#include <qpidit/QpidItErrors.hpp>
 
 namespace qpidit
 {
 
+    // static
+    const uint64_t AmqpSenderBase::s_rawDeliveryTagBit = 1ULL << 63;
+
+    AmqpSenderBase::LinkShard::LinkShard() :
+                    sender(),
+                    msgsSent(0),
+                    msgsConfirmed(0),
+                    doneFlag(false),
+                    endMarkerSent(false),
+                    encodedMessageCache()
+    {}
+
     AmqpSenderBase::AmqpSenderBase(const std::string& testName,
                                    const std::string& brokerAddr,
                                    const std::string& queueName,
-                                   uint32_t totalMsgs):
-                    AmqpTestBase(testName, brokerAddr, queueName),
+                                   uint32_t totalMsgs,
+                                   const ShimOptions& options):
+                    AmqpTestBase(testName, brokerAddr, queueName, options),
                     _totalMsgs(totalMsgs),
                     _msgsSent(0),
-                    _msgsConfirmed(0)
+                    _sendCursorMutex(),
+                    _cursorExhausted(false),
+                    _endMarkers(false),
+                    _msgsConfirmed(0),
+                    _preEncoded(options.getFlag("pre-encoded")),
+                    _latencyFlag(options.getFlag("latency")),
+                    _atMostOnce(getAtMostOnceFlag(options)),
+                    _linkShards(getNumLinks()),
+                    _connectionsDone(0)
     {}
 
     AmqpSenderBase::~AmqpSenderBase() {}
 
-    void AmqpSenderBase::on_container_start(proton::container &c) {
-        std::ostringstream oss;
-        oss << _brokerAddr << "/" << _queueName;
-        proton::reconnect_options ro;
-        ro.max_attempts(2);
-        proton::connection_options co;
-        co.reconnect(ro);
-        c.open_sender(oss.str(), co);
+    void AmqpSenderBase::on_sendable(proton::sender &s) {
+        AllocTracker::advancePhase(AllocTracker::TRANSFER);
+        const uint32_t linkIndex = getLinkIndex(s);
+        LinkShard& linkShard = _linkShards[linkIndex];
+        // Claim as many messages from the send cursor as there is credit, each time credit is issued
+        // until the workload is done
+        uint32_t firstMsgNum;
+        const uint32_t numMsgs = claimMessages(s.credit(), firstMsgNum);
+        if (numMsgs > 0) {
+            proton::message msg;
+            for (uint32_t msgNum=firstMsgNum; msgNum<firstMsgNum+numMsgs; ++msgNum) {
+                beforeSend(msgNum);
+                if (_preEncoded) {
+                    sendPreEncoded(linkShard, s, msgNum);
+                } else {
+                    msg.clear();
+                    setMessage(msg, msgNum);
+                    if (_latencyFlag) {
+                        msg.properties().put(PerfStats::s_sendTimeProperty, PerfStats::monotonicNs());
+                    }
+                    s.send(msg);
+                }
+                linkShard.msgsSent++;
+            }
+        }
+        if (_msgsSent >= _totalMsgs) {
+            sendEndMarker(linkShard, s);
+            // The first link to see the cursor exhausted: links that will not see on_sendable again, having no
+            // credit or no more messages to use it on, are finished by their own connection.
+            if (getNumLinks() > 1 && !_cursorExhausted.exchange(true)) {
+                for (uint32_t i=0; i<_numConnections; ++i) {
+                    proton::work_queue* workQueue = _connectionShards[i].workQueue;
+                    if (workQueue != 0) {
+                        workQueue->add([this, i]() { finishConnectionLinks(i); });
+                    }
+                }
+            }
+        }
+        checkLinkDone(linkShard, linkIndex);
     }
 
-    void AmqpSenderBase::on_tracker_accept(proton::tracker &t) {
-        _msgsConfirmed++;
-        if (_msgsConfirmed >= _totalMsgs) {
-            t.connection().close();
+    void AmqpSenderBase::on_sender_drain_start(proton::sender &s) {
+        // on_sendable has already used all the credit it could, the rest can be returned to the receiver
+        if (_msgsSent >= _totalMsgs) {
+            sendEndMarker(_linkShards[getLinkIndex(s)], s);
+            s.return_credit();
         }
     }
 
+    void AmqpSenderBase::on_tracker_accept(proton::tracker &t) {
+        const uint32_t linkIndex = getLinkIndex(t.sender());
+        LinkShard& linkShard = _linkShards[linkIndex];
+        linkShard.msgsConfirmed++;
+        checkLinkDone(linkShard, linkIndex);
+    }
+
     void AmqpSenderBase::on_transport_close(proton::transport &t) {
-        _msgsSent = _msgsConfirmed;
+        // A single link resends from its last confirmed message on reconnect. With more than one link,
+        // messages cannot be reassigned between links, and messages sent at-most-once are not sent again.
+        if (getNumLinks() == 1 && !_atMostOnce && !_linkShards[0].doneFlag) {
+            std::lock_guard<std::mutex> lock(_sendCursorMutex);
+            LinkShard& linkShard = _linkShards[0];
+            linkShard.msgsSent = linkShard.msgsConfirmed;
+            linkShard.endMarkerSent = false;
+            _msgsSent = linkShard.msgsConfirmed;
+        }
+    }
+
+    // protected
+
+    uint32_t AmqpSenderBase::getContentKey(uint32_t msgNum) const {
+        return msgNum;
+    }
+
+    void AmqpSenderBase::beforeSend(uint32_t /*msgNum*/) {}
+
+    void AmqpSenderBase::openLink(proton::connection& c, uint32_t linkIndex) {
+        proton::sender_options so;
+        so.name(getLinkName(linkIndex));
+        if (_atMostOnce) {
+            so.delivery_mode(proton::delivery_mode::AT_MOST_ONCE);
+        }
+        _linkShards[linkIndex].sender = c.open_sender(_queueName, so);
+    }
+
+    // Returns the number of messages claimed, from firstMsgNum
+    uint32_t AmqpSenderBase::claimMessages(uint32_t credit, uint32_t& firstMsgNum) {
+        std::lock_guard<std::mutex> lock(_sendCursorMutex);
+        firstMsgNum = _msgsSent;
+        if (firstMsgNum >= _totalMsgs) return 0;
+        const uint32_t numMsgs = std::min(credit, _totalMsgs - firstMsgNum);
+        _msgsSent = firstMsgNum + numMsgs;
+        return numMsgs;
+    }
+
+    void AmqpSenderBase::sendPreEncoded(LinkShard& linkShard, proton::sender& s, uint32_t msgNum) {
+        const uint32_t contentKey = getContentKey(msgNum);
+        if (contentKey >= linkShard.encodedMessageCache.size()) {
+            linkShard.encodedMessageCache.resize(contentKey + 1);
+        }
+        EncodedMessage& encodedMessage = linkShard.encodedMessageCache[contentKey];
+        if (encodedMessage.empty()) {
+            proton::message msg;
+            setMessage(msg, msgNum);
+            if (_latencyFlag) {
+                msg.properties().put(PerfStats::s_sendTimeProperty, int64_t(0));
+            }
+            encodedMessage.encode(msg);
+        }
+        encodedMessage.setId(msgNum + 1);
+        if (_latencyFlag) {
+            encodedMessage.setSendTime(PerfStats::monotonicNs());
+        }
+        encodedMessage.send(s, s_rawDeliveryTagBit | msgNum);
+    }
+
+    // Each link sends its own end marker after its last message, as one sent on a single link could overtake
+    // messages still in flight on the others. It carries the number of links and the number of messages its
+    // link sent, so that the receiver can tell once everything sent has arrived. Waits for credit if there is
+    // none left.
+    void AmqpSenderBase::sendEndMarker(LinkShard& linkShard, proton::sender& s) {
+        if (!_endMarkers || linkShard.endMarkerSent || linkShard.doneFlag || s.credit() <= 0) return;
+        proton::message msg;
+        msg.subject(PerfStats::s_endMarkerSubject);
+        msg.properties().put(PerfStats::s_endMarkerLinksProperty, getNumLinks());
+        msg.properties().put(PerfStats::s_endMarkerMsgsProperty, linkShard.msgsSent);
+        s.send(msg);
+        linkShard.endMarkerSent = true;
+    }
+
+    // A link is done once the send cursor is exhausted, its end marker (if any) is sent, and everything it
+    // sent is confirmed (pre-settled messages are never accepted, so at-most-once links are done once sent).
+    // A connection is closed once all its links are done.
+    void AmqpSenderBase::checkLinkDone(LinkShard& linkShard, uint32_t linkIndex) {
+        if (linkShard.doneFlag || _msgsSent < _totalMsgs) return;
+        if (_endMarkers && !linkShard.endMarkerSent) return;
+        const uint32_t msgsToConfirm = linkShard.msgsSent + (linkShard.endMarkerSent ? 1 : 0);
+        if (!_atMostOnce && linkShard.msgsConfirmed < msgsToConfirm) return;
+        linkShard.doneFlag = true;
+        ConnectionShard& connectionShard = _connectionShards[linkIndex / _linksPerConnection];
+        if (++connectionShard.linksDone < _linksPerConnection) return;
+        connectionShard.connection.close();
+        if (++_connectionsDone == _numConnections) {
+            AllocTracker::advancePhase(AllocTracker::SHUTDOWN);
+            // All links are done, so no other thread updates the shards
+            uint32_t msgsConfirmed = 0;
+            for (LinkShardList_t::const_iterator i=_linkShards.begin(); i!=_linkShards.end(); ++i) {
+                msgsConfirmed += _atMostOnce ? i->msgsSent : i->msgsConfirmed - (i->endMarkerSent ? 1 : 0);
+            }
+            _msgsConfirmed = msgsConfirmed;
+        }
+    }
+
+    // Sends any end markers due on the connection's links, and checks if they are done
+    void AmqpSenderBase::finishConnectionLinks(uint32_t connectionIndex) {
+        for (uint32_t i=0; i<_linksPerConnection; ++i) {
+            const uint32_t linkIndex = connectionIndex * _linksPerConnection + i;
+            LinkShard& linkShard = _linkShards[linkIndex];
+            sendEndMarker(linkShard, linkShard.sender);
+            checkLinkDone(linkShard, linkIndex);
+        }
+    }
+
+    bool AmqpSenderBase::isComplete() const {
+        return _connectionsDone >= _numConnections;
+    }
+
+    // static
+    bool AmqpSenderBase::getAtMostOnceFlag(const ShimOptions& options) {
+        const std::string deliveryMode(options.getString("delivery-mode", "at-least-once"));
+        if (deliveryMode.compare("at-most-once") == 0) return true;
+        if (deliveryMode.compare("at-least-once") == 0) return false;
+        throw qpidit::ArgumentError(MSG("Unknown delivery mode \"" << deliveryMode << "\", expected \"at-least-once\" or \"at-most-once\""));
     }
 
 } // namespace qpidit
@@ -22,9 +22,16 @@
 #ifndef SRC_QPIDIT_AMQPSENDERBASE_HPP_
 #define SRC_QPIDIT_AMQPSENDERBASE_HPP_
 
+#include <atomic>
+#include <mutex>
 #include <stdint.h>
+#include <vector>
+#include <proton/message.hpp>
 #include <proton/messaging_handler.hpp>
+#include <qpidit/AlignedAllocator.hpp>
 #include <qpidit/AmqpTestBase.hpp>
+#include <qpidit/EncodedMessage.hpp>
+#include <qpidit/ShimOptions.hpp>
 
 namespace qpidit
 {
@@ -32,20 +39,65 @@ namespace qpidit
     class AmqpSenderBase : public AmqpTestBase
     {
     protected:
-        uint32_t _totalMsgs;
-        uint32_t _msgsSent;
-        uint32_t _msgsConfirmed;
+        // Send state of one link, only accessed from its connection's handler thread.
+        // Aligned to a cache line so that links handled by different threads do not share one.
+        struct alignas(64) LinkShard
+        {
+            proton::sender sender;
+            uint32_t msgsSent;
+            uint32_t msgsConfirmed;
+            bool doneFlag;
+            bool endMarkerSent;
+            std::vector<EncodedMessage> encodedMessageCache; // indexed by content key
+            LinkShard();
+        };
+        typedef std::vector<LinkShard, AlignedAllocator<LinkShard> > LinkShardList_t;
+
+        // Delivery tags of messages sent without proton::sender::send() have this bit set, keeping them apart from
+        // the tags of proton's own counter (from 1), which end markers and other messages on the link use
+        static const uint64_t s_rawDeliveryTagBit;
+
+        std::atomic<uint32_t> _totalMsgs;
+        std::atomic<uint32_t> _msgsSent; // Send cursor shared by all links, each link claims its next messages from it
+        std::mutex _sendCursorMutex; // Held to claim from the send cursor, and to change _totalMsgs once sending has started
+        std::atomic<bool> _cursorExhausted;
+        bool _endMarkers; // Each link ends with an end marker message once the send cursor is exhausted, set before sending
+        uint32_t _msgsConfirmed; // Merged from the link shards once complete
+        const bool _preEncoded; // --pre-encoded: encode each distinct message once, then send raw bytes
+        const bool _latencyFlag; // --latency: stamp each message with its send time
+        const bool _atMostOnce; // --delivery-mode at-most-once: pre-settled sends, complete once all are sent
+        LinkShardList_t _linkShards;
+        std::atomic<uint32_t> _connectionsDone;
 
     public:
         AmqpSenderBase(const std::string& testName,
                        const std::string& brokerAddr,
                        const std::string& queueName,
-                       uint32_t totalMsgs);
+                       uint32_t totalMsgs,
+                       const ShimOptions& options = ShimOptions());
         virtual ~AmqpSenderBase();
 
-        void on_container_start(proton::container &c);
+        void on_sendable(proton::sender &s);
+        void on_sender_drain_start(proton::sender &s);
         void on_tracker_accept(proton::tracker &t);
         void on_transport_close(proton::transport &t);
+
+    protected:
+        // Set msg to the message at send cursor position msgNum (0 <= msgNum < _totalMsgs)
+        virtual proton::message& setMessage(proton::message& msg, uint32_t msgNum) = 0;
+        // Messages with the same content key differ only in message-id, and may share one pre-encoded message
+        virtual uint32_t getContentKey(uint32_t msgNum) const;
+        // Called on the link's handler thread just before the message at msgNum is sent
+        virtual void beforeSend(uint32_t msgNum);
+        void openLink(proton::connection& c, uint32_t linkIndex);
+        uint32_t claimMessages(uint32_t credit, uint32_t& firstMsgNum);
+        void sendPreEncoded(LinkShard& linkShard, proton::sender& s, uint32_t msgNum);
+        void sendEndMarker(LinkShard& linkShard, proton::sender& s);
+        void checkLinkDone(LinkShard& linkShard, uint32_t linkIndex);
+        void finishConnectionLinks(uint32_t connectionIndex);
+        bool isComplete() const;
+
+        static bool getAtMostOnceFlag(const ShimOptions& options);
     };
 
 } // namespace qpidit
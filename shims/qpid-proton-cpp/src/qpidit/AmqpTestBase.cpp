@@ -21,26 +21,85 @@
 
 #include "qpidit/AmqpTestBase.hpp"
 
+#include <cstdlib>
 #include <iostream>
-#include <proton/connection.hpp>
+#include <sstream>
+#include <proton/connection_options.hpp>
+#include <proton/container.hpp>
 #include <proton/error_condition.hpp>
+#include <proton/link.hpp>
+#include <proton/receiver.hpp>
+#include <proton/reconnect_options.hpp>
 #include <proton/sender.hpp>
 #include <proton/session.hpp>
+#include <proton/thread_safe.hpp> // for proton::returned<>
 #include <proton/transport.hpp>
+#include <proton/work_queue.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace
+{
+    const std::string s_linkNamePrefix("qpidit.");
+}
 
 namespace qpidit
 {
 
+    AmqpTestBase::ConnectionShard::ConnectionShard() :
+                    connection(),
+                    workQueue(0),
+                    linksDone(0)
+    {}
+
     AmqpTestBase::AmqpTestBase(const std::string& testName,
                                const std::string& brokerAddr,
-                               const std::string& queueName):
+                               const std::string& queueName,
+                               const ShimOptions& options):
                     _testName(testName),
                     _brokerAddr(brokerAddr),
-                    _queueName(queueName)
+                    _queueName(queueName),
+                    _numConnections(getPositiveOption(options, "connections")),
+                    _linksPerConnection(getPositiveOption(options, "links-per-connection")),
+                    _numThreads(getPositiveOption(options, "threads")),
+                    _connectionShards(_numConnections),
+                    _connectionsOpened(0),
+                    _closingFlag(false)
     {}
 
     AmqpTestBase::~AmqpTestBase() {}
 
+    uint32_t AmqpTestBase::getNumThreads() const {
+        return _numThreads;
+    }
+
+    void AmqpTestBase::on_container_start(proton::container &c) {
+        AllocTracker::advancePhase(AllocTracker::CONNECT);
+        proton::reconnect_options ro;
+        ro.max_attempts(2);
+        proton::connection_options co;
+        co.reconnect(ro);
+        for (uint32_t i=0; i<_numConnections; ++i) {
+            c.connect(_brokerAddr, co);
+        }
+    }
+
+    void AmqpTestBase::on_connection_open(proton::connection &c) {
+        // Links are opened from the connection's own handler thread. They are not re-established on reconnect.
+        if (c.reconnected()) return;
+        if (_closingFlag) {
+            c.close();
+            return;
+        }
+        const uint32_t connectionIndex = _connectionsOpened++;
+        ConnectionShard& connectionShard = _connectionShards[connectionIndex];
+        connectionShard.connection = c;
+        connectionShard.workQueue = &c.work_queue();
+        for (uint32_t i=0; i<_linksPerConnection; ++i) {
+            openLink(c, connectionIndex * _linksPerConnection + i);
+        }
+    }
+
     void AmqpTestBase::on_connection_error(proton::connection& c) {
         std::cerr << _testName << "::on_connection_error: " << c.error() << std::endl;
     }
@@ -53,6 +112,10 @@ namespace qpidit
         std::cerr << _testName << "::on_sender_error: " << s.error() << std::endl;
     }
 
+    void AmqpTestBase::on_receiver_error(proton::receiver& r) {
+        std::cerr << _testName << "::on_receiver_error: " << r.error() << std::endl;
+    }
+
     void AmqpTestBase::on_transport_error(proton::transport& t) {
         std::cerr << _testName << "::on_transport_error: " << t.error() << std::endl;
     }
@@ -61,4 +124,47 @@ namespace qpidit
         std::cerr << _testName << "::on_error(): " << ec << std::endl;
     }
 
+    // protected
+
+    uint32_t AmqpTestBase::getNumLinks() const {
+        return _numConnections * _linksPerConnection;
+    }
+
+    void AmqpTestBase::closeConnections() {
+        AllocTracker::advancePhase(AllocTracker::SHUTDOWN);
+        _closingFlag = true;
+        for (uint32_t i=0; i<_numConnections; ++i) {
+            proton::work_queue* workQueue = _connectionShards[i].workQueue;
+            if (workQueue != 0) {
+                workQueue->add([this, i]() { closeConnection(i); });
+            }
+        }
+    }
+
+    void AmqpTestBase::closeConnection(uint32_t connectionIndex) {
+        _connectionShards[connectionIndex].connection.close();
+    }
+
+    // static
+    std::string AmqpTestBase::getLinkName(uint32_t linkIndex) {
+        std::ostringstream oss;
+        oss << s_linkNamePrefix << linkIndex;
+        return oss.str();
+    }
+
+    // static
+    uint32_t AmqpTestBase::getLinkIndex(const proton::link& l) {
+        const std::string linkName(l.name());
+        return std::strtoul(linkName.c_str() + s_linkNamePrefix.size(), NULL, 10);
+    }
+
+    // static
+    uint32_t AmqpTestBase::getPositiveOption(const ShimOptions& options, const std::string& name) {
+        const uint64_t val = options.getUInt(name, 1);
+        if (val == 0 || val > UINT32_MAX) {
+            throw qpidit::ArgumentError(MSG("Option \"--" << name << "\" must be between 1 and " << UINT32_MAX));
+        }
+        return val;
+    }
+
 } // namespace qpidit
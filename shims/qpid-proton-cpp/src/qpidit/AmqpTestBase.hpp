@@ -22,8 +22,18 @@
 #ifndef SRC_QPIDIT_AMQPTESTBASE_HPP_
 #define SRC_QPIDIT_AMQPTESTBASE_HPP_
 
+#include <atomic>
+#include <stdint.h>
 #include <string>
+#include <vector>
+#include <proton/connection.hpp>
 #include <proton/messaging_handler.hpp>
+#include <qpidit/ShimOptions.hpp>
+
+namespace proton {
+    class link;
+    class work_queue;
+}
 
 namespace qpidit
 {
@@ -31,21 +41,58 @@ namespace qpidit
     class AmqpTestBase : public proton::messaging_handler
     {
     protected:
+        // A connection opened by this test. Once open, connection is only accessed from its own
+        // handler thread; other threads reach it through workQueue.
+        struct ConnectionShard
+        {
+            proton::connection connection;
+            std::atomic<proton::work_queue*> workQueue;
+            uint32_t linksDone;
+            ConnectionShard();
+        };
+
         const std::string _testName;
         const std::string _brokerAddr;
         const std::string _queueName;
+        const uint32_t _numConnections;     // --connections C
+        const uint32_t _linksPerConnection; // --links-per-connection L
+        const uint32_t _numThreads;         // --threads T: number of container threads
+        std::vector<ConnectionShard> _connectionShards;
+        std::atomic<uint32_t> _connectionsOpened;
+        std::atomic<bool> _closingFlag;
 
     public:
         AmqpTestBase(const std::string& testName,
                      const std::string& brokerAddr,
-                     const std::string& queueName);
+                     const std::string& queueName,
+                     const ShimOptions& options = ShimOptions());
         virtual ~AmqpTestBase();
 
+        uint32_t getNumThreads() const;
+
+        void on_container_start(proton::container& c);
+        void on_connection_open(proton::connection& c);
+
         void on_connection_error(proton::connection& c);
         void on_session_error(proton::session& s);
         void on_sender_error(proton::sender& s);
+        void on_receiver_error(proton::receiver& r);
         void on_transport_error(proton::transport& t);
         void on_error(const proton::error_condition& c);
+
+    protected:
+        uint32_t getNumLinks() const;
+        // Open the link with index linkIndex (0 <= linkIndex < getNumLinks()) on connection c,
+        // named getLinkName(linkIndex) so that handlers can find its shard through getLinkIndex()
+        virtual void openLink(proton::connection& c, uint32_t linkIndex) = 0;
+        // Close every connection, may be called from any connection's handler thread
+        void closeConnections();
+        // Close one connection from its own handler thread
+        virtual void closeConnection(uint32_t connectionIndex);
+
+        static std::string getLinkName(uint32_t linkIndex);
+        static uint32_t getLinkIndex(const proton::link& l);
+        static uint32_t getPositiveOption(const ShimOptions& options, const std::string& name);
     };
 
 } // namespace qpidit
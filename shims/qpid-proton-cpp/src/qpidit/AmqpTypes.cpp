@@ -0,0 +1,109 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/AmqpTypes.hpp"
+
+#include <qpidit/QpidItErrors.hpp>
+
+namespace
+{
+    struct AmqpTypeEntry
+    {
+        const char* name;
+        proton::type_id typeId;
+    };
+
+    constexpr AmqpTypeEntry s_amqpTypeTable[] = {
+        {"null", proton::NULL_TYPE},
+        {"boolean", proton::BOOLEAN},
+        {"ubyte", proton::UBYTE},
+        {"ushort", proton::USHORT},
+        {"uint", proton::UINT},
+        {"ulong", proton::ULONG},
+        {"byte", proton::BYTE},
+        {"short", proton::SHORT},
+        {"int", proton::INT},
+        {"long", proton::LONG},
+        {"float", proton::FLOAT},
+        {"double", proton::DOUBLE},
+        {"decimal32", proton::DECIMAL32},
+        {"decimal64", proton::DECIMAL64},
+        {"decimal128", proton::DECIMAL128},
+        {"char", proton::CHAR},
+        {"timestamp", proton::TIMESTAMP},
+        {"uuid", proton::UUID},
+        {"binary", proton::BINARY},
+        {"string", proton::STRING},
+        {"symbol", proton::SYMBOL},
+        {"list", proton::LIST},
+        {"map", proton::MAP},
+        {"array", proton::ARRAY}
+    };
+    constexpr size_t s_amqpTypeTableSize = sizeof(s_amqpTypeTable) / sizeof(s_amqpTypeTable[0]);
+
+    // Type names indexed by type_id, built once from s_amqpTypeTable
+    struct TypeNameIndex
+    {
+        static const size_t s_size = proton::MAP + 1;
+        std::string names[s_size];
+        TypeNameIndex() {
+            for (size_t i=0; i<s_size; ++i) {
+                names[i] = "unknown";
+            }
+            for (size_t i=0; i<s_amqpTypeTableSize; ++i) {
+                names[s_amqpTypeTable[i].typeId] = s_amqpTypeTable[i].name;
+            }
+        }
+    };
+    const TypeNameIndex s_typeNameIndex;
+    const std::string s_unknownTypeName("unknown");
+}
+
+namespace qpidit
+{
+
+    // static
+    proton::type_id AmqpTypes::typeId(const std::string& amqpType) {
+        proton::type_id typeId;
+        if (!findTypeId(amqpType, typeId)) {
+            throw qpidit::UnknownAmqpTypeError(amqpType);
+        }
+        return typeId;
+    }
+
+    // static
+    bool AmqpTypes::findTypeId(const std::string& amqpType, proton::type_id& typeId) {
+        for (size_t i=0; i<s_amqpTypeTableSize; ++i) {
+            if (amqpType.compare(s_amqpTypeTable[i].name) == 0) {
+                typeId = s_amqpTypeTable[i].typeId;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // static
+    const std::string& AmqpTypes::typeName(proton::type_id typeId) {
+        const size_t index = typeId;
+        return index < TypeNameIndex::s_size ? s_typeNameIndex.names[index] : s_unknownTypeName;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,49 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_AMQPTYPES_HPP_
+#define SRC_QPIDIT_AMQPTYPES_HPP_
+
+#include <proton/type_id.hpp>
+#include <string>
+
+namespace qpidit
+{
+
+    /*
+     * Maps between the AMQP type names used by the test harness ("ubyte", "decimal32", ...) and
+     * proton::type_id, so that a shim resolves its type name once at startup and works with the
+     * type_id from then on.
+     */
+    class AmqpTypes
+    {
+    public:
+        // Throws UnknownAmqpTypeError if amqpType is not an AMQP type name
+        static proton::type_id typeId(const std::string& amqpType);
+        // Returns false and leaves typeId unchanged if amqpType is not an AMQP type name
+        static bool findTypeId(const std::string& amqpType, proton::type_id& typeId);
+        // Returns "unknown" for a type_id with no AMQP type name (ie DESCRIBED)
+        static const std::string& typeName(proton::type_id typeId);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_AMQPTYPES_HPP_ */
@@ -33,48 +33,31 @@ static inline bool is_base64(uint8_t c) {
 }
 
 std::string b64_encode(proton::binary const& str_buf) {
-	uint8_t const* buf = &str_buf[0];
-	uint16_t bufLen = str_buf.size();
 	std::string ret;
-	int i = 0;
-	int j = 0;
-	uint8_t char_array_3[3];
-	uint8_t char_array_4[4];
-
-	while (bufLen--) {
-		char_array_3[i++] = *(buf++);
-		if (i == 3) {
-			char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-			char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-			char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-			char_array_4[3] = char_array_3[2] & 0x3f;
+	b64_encode(str_buf, ret);
+	return ret;
+}
 
-			for(i = 0; (i <4) ; i++) {
-				ret += b64_chars[char_array_4[i]];
-			}
-			i = 0;
-		}
+void b64_encode(proton::binary const& str_buf, std::string& out) {
+	const size_t bufLen = str_buf.size();
+	uint8_t const* buf = bufLen ? &str_buf[0] : 0;
+	out.reserve(out.size() + (bufLen + 2) / 3 * 4);
+	size_t i = 0;
+	for (; i + 3 <= bufLen; i += 3) {
+		const uint32_t triple = (uint32_t(buf[i]) << 16) | (uint32_t(buf[i + 1]) << 8) | buf[i + 2];
+		out += b64_chars[(triple >> 18) & 0x3f];
+		out += b64_chars[(triple >> 12) & 0x3f];
+		out += b64_chars[(triple >> 6) & 0x3f];
+		out += b64_chars[triple & 0x3f];
 	}
-
-	if (i) {
-		for(j = i; j < 3; j++) {
-			char_array_3[j] = '\0';
-		}
-
-		char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-		char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-		char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-		char_array_4[3] = char_array_3[2] & 0x3f;
-
-		for (j = 0; (j < i + 1); j++) {
-			ret += b64_chars[char_array_4[j]];
-		}
-
-		while((i++ < 3))
-			ret += '=';
+	if (i < bufLen) {
+		const bool twoBytes = i + 2 == bufLen;
+		const uint32_t triple = (uint32_t(buf[i]) << 16) | (twoBytes ? uint32_t(buf[i + 1]) << 8 : 0);
+		out += b64_chars[(triple >> 18) & 0x3f];
+		out += b64_chars[(triple >> 12) & 0x3f];
+		out += twoBytes ? b64_chars[(triple >> 6) & 0x3f] : '=';
+		out += '=';
 	}
-
-	return ret;
 }
 
 proton::binary b64_decode(std::string const& encoded_string) {
@@ -27,6 +27,8 @@
 #include <proton/binary.hpp>
 
 std::string b64_encode(proton::binary const&);
+// Appends the encoding to out, so that a caller can reuse one buffer
+void b64_encode(proton::binary const&, std::string& out);
 proton::binary b64_decode(std::string const&);
 
 #endif /* SRC_QPIDIT_BASE64_HPP_ */
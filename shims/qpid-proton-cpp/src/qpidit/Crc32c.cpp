@@ -0,0 +1,233 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/Crc32c.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <endian.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace qpidit
+{
+
+    namespace
+    {
+        typedef uint32_t (*Update_t)(uint32_t crc, const unsigned char* p, size_t size);
+
+        // The update functions work on the inverted CRC, extend() does the inversions
+
+        struct SliceTables
+        {
+            uint32_t table[8][256];
+            SliceTables() {
+                const uint32_t poly = 0x82f63b78; // Castagnoli, bit reversed
+                for (uint32_t i=0; i<256; ++i) {
+                    uint32_t crc = i;
+                    for (int j=0; j<8; ++j) {
+                        crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+                    }
+                    table[0][i] = crc;
+                }
+                for (uint32_t i=0; i<256; ++i) {
+                    for (int k=1; k<8; ++k) {
+                        table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xff];
+                    }
+                }
+            }
+        };
+
+        uint32_t updateSoftware(uint32_t crc, const unsigned char* p, size_t size) {
+            static const SliceTables sliceTables;
+            const uint32_t (&t)[8][256] = sliceTables.table;
+            for (; size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; --size) {
+                crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+            }
+            for (; size >= 8; size -= 8, p += 8) {
+                uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                word = le64toh(word) ^ crc;
+                crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^
+                      t[4][(word >> 24) & 0xff] ^ t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+                      t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+            }
+            for (; size > 0; --size) {
+                crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+#if defined(__x86_64__) || (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+        // The crc32 instruction has a latency of several cycles, so the hardware update runs three
+        // independent CRCs over adjacent blocks and joins them. Joining applies to a CRC the effect
+        // of s_blockSize zero bytes, which is linear in the CRC bits and so is a table lookup per byte.
+        const size_t s_blockSize = 8192; // A power of 2
+
+        struct ShiftTables
+        {
+            uint32_t table[4][256];
+
+            ShiftTables() {
+                // Operator matrix (one column per CRC bit) for one zero bit, squared to double its length
+                uint32_t matrices[2][32];
+                uint32_t* op = matrices[0];
+                uint32_t* other = matrices[1];
+                op[0] = 0x82f63b78;
+                for (int n=1; n<32; ++n) {
+                    op[n] = 1U << (n - 1);
+                }
+                for (size_t bits=1; bits<8*s_blockSize; bits<<=1) {
+                    square(other, op);
+                    std::swap(op, other);
+                }
+                for (uint32_t n=0; n<256; ++n) {
+                    for (int k=0; k<4; ++k) {
+                        table[k][n] = times(op, n << (8 * k));
+                    }
+                }
+            }
+
+            static uint32_t times(const uint32_t* mat, uint32_t vec) {
+                uint32_t sum = 0;
+                for (; vec != 0; vec >>= 1, ++mat) {
+                    if (vec & 1) sum ^= *mat;
+                }
+                return sum;
+            }
+
+            static void square(uint32_t* square, const uint32_t* mat) {
+                for (int n=0; n<32; ++n) {
+                    square[n] = times(mat, mat[n]);
+                }
+            }
+        };
+
+        // crc followed by s_blockSize zero bytes
+        inline uint32_t shiftBlock(uint32_t crc) {
+            static const ShiftTables shiftTables;
+            const uint32_t (&t)[4][256] = shiftTables.table;
+            return t[0][crc & 0xff] ^ t[1][(crc >> 8) & 0xff] ^ t[2][(crc >> 16) & 0xff] ^ t[3][crc >> 24];
+        }
+#endif
+
+#if defined(__x86_64__)
+        __attribute__((target("sse4.2")))
+        uint32_t updateHardware(uint32_t crc, const unsigned char* p, size_t size) {
+            for (; size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; --size) {
+                crc = _mm_crc32_u8(crc, *p++);
+            }
+            uint64_t crc0 = crc;
+            for (; size >= 3 * s_blockSize; size -= 3 * s_blockSize, p += 2 * s_blockSize) {
+                uint64_t crc1 = 0;
+                uint64_t crc2 = 0;
+                for (const unsigned char* end = p + s_blockSize; p < end; p += 8) {
+                    uint64_t word0, word1, word2;
+                    std::memcpy(&word0, p, sizeof(word0));
+                    std::memcpy(&word1, p + s_blockSize, sizeof(word1));
+                    std::memcpy(&word2, p + 2 * s_blockSize, sizeof(word2));
+                    crc0 = _mm_crc32_u64(crc0, word0);
+                    crc1 = _mm_crc32_u64(crc1, word1);
+                    crc2 = _mm_crc32_u64(crc2, word2);
+                }
+                crc0 = shiftBlock(uint32_t(crc0)) ^ uint32_t(crc1);
+                crc0 = shiftBlock(uint32_t(crc0)) ^ uint32_t(crc2);
+            }
+            for (; size >= 8; size -= 8, p += 8) {
+                uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                crc0 = _mm_crc32_u64(crc0, word);
+            }
+            crc = uint32_t(crc0);
+            for (; size > 0; --size) {
+                crc = _mm_crc32_u8(crc, *p++);
+            }
+            return crc;
+        }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+        uint32_t updateHardware(uint32_t crc, const unsigned char* p, size_t size) {
+            for (; size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; --size) {
+                crc = __crc32cb(crc, *p++);
+            }
+            for (; size >= 3 * s_blockSize; size -= 3 * s_blockSize, p += 2 * s_blockSize) {
+                uint32_t crc1 = 0;
+                uint32_t crc2 = 0;
+                for (const unsigned char* end = p + s_blockSize; p < end; p += 8) {
+                    uint64_t word0, word1, word2;
+                    std::memcpy(&word0, p, sizeof(word0));
+                    std::memcpy(&word1, p + s_blockSize, sizeof(word1));
+                    std::memcpy(&word2, p + 2 * s_blockSize, sizeof(word2));
+                    crc = __crc32cd(crc, word0);
+                    crc1 = __crc32cd(crc1, word1);
+                    crc2 = __crc32cd(crc2, word2);
+                }
+                crc = shiftBlock(crc) ^ crc1;
+                crc = shiftBlock(crc) ^ crc2;
+            }
+            for (; size >= 8; size -= 8, p += 8) {
+                uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                crc = __crc32cd(crc, word);
+            }
+            for (; size > 0; --size) {
+                crc = __crc32cb(crc, *p++);
+            }
+            return crc;
+        }
+#endif
+
+        Update_t selectUpdate() {
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse4.2")) {
+                return updateHardware;
+            }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+            return updateHardware;
+#endif
+            return updateSoftware;
+        }
+
+        Update_t update() {
+            static const Update_t update = selectUpdate();
+            return update;
+        }
+    }
+
+    // static
+    uint32_t Crc32c::compute(const char* data, size_t size) {
+        return extend(0, data, size);
+    }
+
+    // static
+    uint32_t Crc32c::extend(uint32_t crc, const char* data, size_t size) {
+        return ~update()(~crc, reinterpret_cast<const unsigned char*>(data), size);
+    }
+
+    // static
+    bool Crc32c::isHardwareAccelerated() {
+        return update() != updateSoftware;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,46 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_CRC32C_HPP_
+#define SRC_QPIDIT_CRC32C_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace qpidit
+{
+
+    /*
+     * CRC-32C (Castagnoli), using the SSE4.2 or ARMv8 CRC32 instructions where the CPU has them and
+     * a slicing-by-8 table lookup otherwise.
+     */
+    class Crc32c
+    {
+    public:
+        static uint32_t compute(const char* data, size_t size);
+        // Continues crc, the result of an earlier call, over data, so that a buffer can be checksummed in pieces
+        static uint32_t extend(uint32_t crc, const char* data, size_t size);
+        static bool isHardwareAccelerated();
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_CRC32C_HPP_ */
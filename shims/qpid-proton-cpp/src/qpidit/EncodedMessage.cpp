@@ -0,0 +1,135 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/EncodedMessage.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <endian.h>
+#include <proton/delivery.h>
+#include <proton/link.h>
+#include <proton/message.hpp>
+#include <proton/scalar.hpp>
+#include <proton/sender.hpp>
+#include <qpidit/PerfStats.hpp>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace
+{
+    // Encoded as ulong (0x80) rather than smallulong or ulong0, so every id patched in later has the same width
+    const uint64_t s_idSentinel = 0xffffffffffffffffULL;
+    // Encoded as long (0x81) rather than smalllong
+    const int64_t s_sendTimeSentinel = 0x7fffffffffffffffLL;
+
+    // Gives access to the proton-c link underlying a proton::sender
+    class RawSender : public proton::sender
+    {
+    public:
+        RawSender(const proton::sender& s) : proton::sender(s) {}
+        pn_link_t* pnLink() const { return pn_object(); }
+    };
+}
+
+namespace qpidit
+{
+
+    EncodedMessage::EncodedMessage() : _bytes(), _idOffset(0), _sendTimeOffset(0) {}
+
+    EncodedMessage::~EncodedMessage() {}
+
+    bool EncodedMessage::empty() const {
+        return _bytes.empty();
+    }
+
+    void EncodedMessage::encode(proton::message& msg) {
+        msg.id(s_idSentinel);
+        const bool sendTimeFlag = msg.properties().exists(PerfStats::s_sendTimeProperty);
+        if (sendTimeFlag) {
+            msg.properties().put(PerfStats::s_sendTimeProperty, s_sendTimeSentinel);
+        }
+        msg.encode(_bytes);
+        _idOffset = findIdOffset(_bytes);
+        _sendTimeOffset = sendTimeFlag ? findSendTimeOffset(_bytes) : 0;
+    }
+
+    void EncodedMessage::setId(uint64_t id) {
+        const uint64_t beId = htobe64(id);
+        std::memcpy(&_bytes[_idOffset], &beId, sizeof(beId));
+    }
+
+    void EncodedMessage::setSendTime(int64_t sendTimeNs) {
+        if (_sendTimeOffset == 0) return;
+        const uint64_t beSendTime = htobe64(sendTimeNs);
+        std::memcpy(&_bytes[_sendTimeOffset], &beSendTime, sizeof(beSendTime));
+    }
+
+    void EncodedMessage::send(proton::sender& s, uint64_t deliveryTag) const {
+        pn_link_t* link = RawSender(s).pnLink();
+        pn_delivery_t* d = pn_delivery(link, pn_dtag(reinterpret_cast<const char*>(&deliveryTag), sizeof(deliveryTag)));
+        pn_link_send(link, _bytes.data(), _bytes.size());
+        pn_link_advance(link);
+        if (pn_link_snd_settle_mode(link) == PN_SND_SETTLED) {
+            pn_delivery_settle(d);
+        }
+    }
+
+    // protected
+
+    // static
+    size_t EncodedMessage::findIdOffset(const std::vector<char>& bytes) {
+        // The message-id is the first field of the properties section: descriptor 0x00 0x53 0x73,
+        // then a list8 (0xc0 size count) or list32 (0xd0 size count) constructor, then the ulong id
+        static const char propertiesDescriptor[] = {'\x00', '\x53', '\x73'};
+        static const char idSentinel[] = {'\x80', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'};
+        for (size_t i=0; i+sizeof(propertiesDescriptor)<bytes.size(); ++i) {
+            if (std::memcmp(&bytes[i], propertiesDescriptor, sizeof(propertiesDescriptor)) != 0) continue;
+            const size_t listOffset = i + sizeof(propertiesDescriptor);
+            size_t idOffset;
+            switch (uint8_t(bytes[listOffset])) {
+            case 0xc0: idOffset = listOffset + 3; break;
+            case 0xd0: idOffset = listOffset + 9; break;
+            default: continue;
+            }
+            if (idOffset + sizeof(idSentinel) <= bytes.size() &&
+                std::memcmp(&bytes[idOffset], idSentinel, sizeof(idSentinel)) == 0) {
+                return idOffset + 1;
+            }
+        }
+        throw qpidit::InvalidTestValueError("Unable to locate message-id in encoded message");
+    }
+
+    // static
+    size_t EncodedMessage::findSendTimeOffset(const std::vector<char>& bytes) {
+        // Application property key as str8 (0xa1 len key), followed by the long sentinel value
+        std::string pattern(1, '\xa1');
+        pattern += char(PerfStats::s_sendTimeProperty.size());
+        pattern += PerfStats::s_sendTimeProperty;
+        pattern += '\x81';
+        pattern += '\x7f';
+        pattern.append(7, '\xff');
+        std::vector<char>::const_iterator i = std::search(bytes.begin(), bytes.end(), pattern.begin(), pattern.end());
+        if (i == bytes.end()) {
+            throw qpidit::InvalidTestValueError("Unable to locate send time property in encoded message");
+        }
+        return (i - bytes.begin()) + pattern.size() - sizeof(s_sendTimeSentinel);
+    }
+
+} // namespace qpidit
@@ -0,0 +1,67 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_ENCODEDMESSAGE_HPP_
+#define SRC_QPIDIT_ENCODEDMESSAGE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace proton {
+    class message;
+    class sender;
+}
+
+namespace qpidit
+{
+
+    /*
+     * A message encoded once into AMQP wire format, which can be sent any number of times
+     * with a different message-id (and send time, if present). These are encoded as fixed-width
+     * ulong / long values so that they can be patched in place, and the bytes are sent directly
+     * on the underlying proton-c link, bypassing the encode in proton::sender::send().
+     */
+    class EncodedMessage
+    {
+    protected:
+        std::vector<char> _bytes;
+        size_t _idOffset; // Offset of the 8-byte big-endian message-id value in _bytes
+        size_t _sendTimeOffset; // Offset of the 8-byte big-endian send time property value, 0 if none
+
+    public:
+        EncodedMessage();
+        virtual ~EncodedMessage();
+
+        bool empty() const;
+        void encode(proton::message& msg); // Overwrites the message-id and send time property of msg
+        void setId(uint64_t id);
+        void setSendTime(int64_t sendTimeNs);
+        void send(proton::sender& s, uint64_t deliveryTag) const;
+
+    protected:
+        static size_t findIdOffset(const std::vector<char>& bytes);
+        static size_t findSendTimeOffset(const std::vector<char>& bytes);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_ENCODEDMESSAGE_HPP_ */
@@ -0,0 +1,107 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/LatencyHistogram.hpp"
+
+#include <cmath>
+
+namespace qpidit
+{
+
+    LatencyHistogram::LatencyHistogram() :
+                    _counts(bucketIndex(UINT64_MAX) + 1, 0),
+                    _totalCount(0),
+                    _minNs(UINT64_MAX),
+                    _maxNs(0),
+                    _sumNs(0.0)
+    {}
+
+    LatencyHistogram::~LatencyHistogram() {}
+
+    void LatencyHistogram::record(int64_t latencyNs) {
+        const uint64_t v = latencyNs < 0 ? 0 : latencyNs; // Guard against clock adjustments between processes
+        _counts[bucketIndex(v)]++;
+        _totalCount++;
+        _sumNs += v;
+        if (v < _minNs) _minNs = v;
+        if (v > _maxNs) _maxNs = v;
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) {
+        for (size_t i=0; i<_counts.size(); ++i) {
+            _counts[i] += other._counts[i];
+        }
+        _totalCount += other._totalCount;
+        _sumNs += other._sumNs;
+        if (other._minNs < _minNs) _minNs = other._minNs;
+        if (other._maxNs > _maxNs) _maxNs = other._maxNs;
+    }
+
+    uint64_t LatencyHistogram::percentile(double pct) const {
+        if (_totalCount == 0) return 0;
+        uint64_t target = std::ceil(pct / 100.0 * _totalCount);
+        if (target == 0) target = 1;
+        uint64_t cumulativeCount = 0;
+        for (size_t i=0; i<_counts.size(); ++i) {
+            cumulativeCount += _counts[i];
+            if (cumulativeCount >= target) {
+                const uint64_t v = bucketHighestValue(i);
+                return v < _maxNs ? v : _maxNs;
+            }
+        }
+        return _maxNs;
+    }
+
+    Json::Value LatencyHistogram::toJson() const {
+        Json::Value latency(Json::objectValue);
+        latency["count"] = Json::UInt64(_totalCount);
+        latency["minNs"] = Json::UInt64(_totalCount ? _minNs : 0);
+        latency["meanNs"] = _totalCount ? double(_sumNs / _totalCount) : 0.0;
+        latency["p50Ns"] = Json::UInt64(percentile(50.0));
+        latency["p99Ns"] = Json::UInt64(percentile(99.0));
+        latency["p99.9Ns"] = Json::UInt64(percentile(99.9));
+        latency["maxNs"] = Json::UInt64(_maxNs);
+        return latency;
+    }
+
+    // protected
+
+    // static
+    // Values below s_subBucketCount map to themselves. Above that, a value with its most significant bit
+    // at position m is shifted right by e = m - (s_subBucketBits - 1), leaving a sub-bucket in
+    // [s_subBucketHalfCount, s_subBucketCount), so that index = e * s_subBucketHalfCount + (v >> e).
+    size_t LatencyHistogram::bucketIndex(uint64_t v) {
+        if (v < s_subBucketCount) return v;
+        const unsigned msb = 63 - __builtin_clzll(v);
+        const unsigned e = msb - (s_subBucketBits - 1);
+        return e * s_subBucketHalfCount + (v >> e);
+    }
+
+    // static
+    uint64_t LatencyHistogram::bucketHighestValue(size_t index) {
+        if (index < s_subBucketCount) return index;
+        const unsigned e = index / s_subBucketHalfCount - 1;
+        const uint64_t subBucket = index - e * s_subBucketHalfCount;
+        const uint64_t highest = ((subBucket + 1) << e) - 1;
+        return highest < (subBucket << e) ? UINT64_MAX : highest; // Top bucket overflows
+    }
+
+} // namespace qpidit
@@ -0,0 +1,68 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_LATENCYHISTOGRAM_HPP_
+#define SRC_QPIDIT_LATENCYHISTOGRAM_HPP_
+
+#include <json/value.h>
+#include <stdint.h>
+#include <vector>
+
+namespace qpidit
+{
+
+    /*
+     * Log-linear (HDR-style) histogram of latencies in nanoseconds. Each power of 2 range is
+     * split into s_subBucketHalfCount linear sub-buckets, so every recorded value is held to
+     * within 1/64 (about 1.6%) of its true value, over the full uint64_t range, in fixed memory.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static const unsigned s_subBucketBits = 7;
+        static const uint64_t s_subBucketCount = 1 << s_subBucketBits;
+        static const uint64_t s_subBucketHalfCount = s_subBucketCount / 2;
+
+    protected:
+        std::vector<uint64_t> _counts;
+        uint64_t _totalCount;
+        uint64_t _minNs;
+        uint64_t _maxNs;
+        long double _sumNs;
+
+    public:
+        LatencyHistogram();
+        virtual ~LatencyHistogram();
+
+        void record(int64_t latencyNs);
+        void merge(const LatencyHistogram& other);
+        inline uint64_t count() const { return _totalCount; }
+        uint64_t percentile(double pct) const; // Highest value equivalent to the percentile bucket
+        Json::Value toJson() const;
+
+    protected:
+        static size_t bucketIndex(uint64_t v);
+        static uint64_t bucketHighestValue(size_t index);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_LATENCYHISTOGRAM_HPP_ */
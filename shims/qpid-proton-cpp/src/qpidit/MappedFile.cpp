@@ -0,0 +1,109 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/MappedFile.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+
+    // static
+    const size_t MappedFile::s_hugePageSize = 2 * 1024 * 1024;
+
+    MappedFile::MappedFile(const std::string& fileName, bool hugePagesFlag) :
+                    _fileName(fileName),
+                    _data(0),
+                    _size(0),
+                    _mappedSize(0)
+    {
+        const int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw qpidit::ErrnoError("open", errno);
+        }
+        try {
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                throw qpidit::ErrnoError("fstat", errno);
+            }
+            _size = st.st_size;
+            if (_size == 0) {
+                throw qpidit::ArgumentError(MSG("File \"" << fileName << "\" is empty"));
+            }
+            if (hugePagesFlag) {
+                readIntoHugePages(fd);
+            } else {
+                mapFile(fd);
+            }
+        } catch (const std::exception&) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        ::munmap(_data, _mappedSize);
+    }
+
+    // protected
+
+    // Pages are faulted in up front, so that sending does not stop for disk reads
+    void MappedFile::mapFile(int fd) {
+        void* addr = ::mmap(0, _size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            throw qpidit::ErrnoError("mmap", errno);
+        }
+        _data = static_cast<char*>(addr);
+        _mappedSize = _size;
+    }
+
+    void MappedFile::readIntoHugePages(int fd) {
+        const size_t mappedSize = (_size + s_hugePageSize - 1) / s_hugePageSize * s_hugePageSize;
+        void* addr = ::mmap(0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr == MAP_FAILED) {
+            addr = ::mmap(0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED) {
+                throw qpidit::ErrnoError("mmap", errno);
+            }
+            ::madvise(addr, mappedSize, MADV_HUGEPAGE); // Advisory, the pages are still usable without
+        }
+        char* data = static_cast<char*>(addr);
+        for (size_t offset=0; offset<_size; ) {
+            const ssize_t n = ::read(fd, data + offset, _size - offset);
+            if (n <= 0) {
+                const int errorNum = n < 0 ? errno : EIO; // File shrank while being read
+                ::munmap(addr, mappedSize);
+                throw qpidit::ErrnoError("read", errorNum);
+            }
+            offset += n;
+        }
+        ::mprotect(addr, mappedSize, PROT_READ);
+        _data = data;
+        _mappedSize = mappedSize;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,62 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_MAPPEDFILE_HPP_
+#define SRC_QPIDIT_MAPPEDFILE_HPP_
+
+#include <stddef.h>
+#include <string>
+
+namespace qpidit
+{
+
+    /*
+     * The whole of a file in memory, read-only, so that message bodies can be sent from it in place.
+     * The file is normally mapped directly. With hugePagesFlag it is instead read once into an anonymous
+     * mapping backed by huge pages: reserved ones (MAP_HUGETLB) if there are enough, otherwise
+     * transparent huge pages, which cuts TLB misses when large bodies are read through repeatedly.
+     */
+    class MappedFile
+    {
+    protected:
+        static const size_t s_hugePageSize;
+
+        const std::string _fileName;
+        char* _data;
+        size_t _size;
+        size_t _mappedSize;
+
+    public:
+        MappedFile(const std::string& fileName, bool hugePagesFlag);
+        virtual ~MappedFile();
+
+        inline const char* data() const { return _data; }
+        inline size_t size() const { return _size; }
+        inline const std::string& fileName() const { return _fileName; }
+
+    protected:
+        void mapFile(int fd);
+        void readIntoHugePages(int fd);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_MAPPEDFILE_HPP_ */
@@ -0,0 +1,81 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/NdjsonWriter.hpp"
+
+#include <sstream>
+
+namespace qpidit
+{
+
+    const std::string NdjsonWriter::s_summaryKey("qpidit.summary");
+
+    NdjsonWriter::NdjsonWriter(std::ostream& os, size_t bufferSize) :
+                    _os(os),
+                    _bufferSize(bufferSize),
+                    _buffer(),
+                    _jsonWriter(),
+                    _recordCount(0)
+    {
+        Json::StreamWriterBuilder wbuilder;
+        wbuilder["indentation"] = "";
+        _jsonWriter.reset(wbuilder.newStreamWriter());
+        _buffer.reserve(_bufferSize);
+    }
+
+    NdjsonWriter::~NdjsonWriter() {
+        flush();
+    }
+
+    void NdjsonWriter::writeLine(const std::string& line) {
+        _buffer.append(line);
+        _buffer.push_back('\n');
+        if (_buffer.size() >= _bufferSize) {
+            flush();
+        }
+    }
+
+    void NdjsonWriter::writeRecord(const Json::Value& record) {
+        std::ostringstream oss;
+        _jsonWriter->write(record, &oss);
+        writeLine(oss.str());
+        ++_recordCount;
+    }
+
+    void NdjsonWriter::writeSummary(const Json::Value& summary) {
+        Json::Value summaryRecord(Json::objectValue);
+        summaryRecord[s_summaryKey] = summary;
+        summaryRecord[s_summaryKey]["records"] = Json::UInt64(_recordCount);
+        std::ostringstream oss;
+        _jsonWriter->write(summaryRecord, &oss);
+        writeLine(oss.str());
+        flush();
+    }
+
+    void NdjsonWriter::flush() {
+        if (!_buffer.empty()) {
+            _os.write(_buffer.data(), _buffer.size());
+            _buffer.clear();
+        }
+        _os.flush();
+    }
+
+} // namespace qpidit
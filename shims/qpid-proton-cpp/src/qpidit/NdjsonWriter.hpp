@@ -0,0 +1,69 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_NDJSONWRITER_HPP_
+#define SRC_QPIDIT_NDJSONWRITER_HPP_
+
+#include <json/value.h>
+#include <json/writer.h>
+#include <memory>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+
+namespace qpidit
+{
+
+    /*
+     * Writes result records as newline-delimited JSON, one compact JSON value per line, so that
+     * a receiver can report each result as it is produced rather than holding them all until the
+     * end. Lines are collected in a buffer of bounded size, which is written and flushed to the
+     * stream whenever it fills. The last line is a summary object with the single member
+     * s_summaryKey, which tells the reader that the stream is complete.
+     */
+    class NdjsonWriter
+    {
+    public:
+        static const std::string s_summaryKey;
+        static const size_t s_defaultBufferSize = 64 * 1024;
+
+    protected:
+        std::ostream& _os;
+        const size_t _bufferSize;
+        std::string _buffer;
+        std::unique_ptr<Json::StreamWriter> _jsonWriter;
+        uint64_t _recordCount;
+
+    public:
+        NdjsonWriter(std::ostream& os, size_t bufferSize = s_defaultBufferSize);
+        virtual ~NdjsonWriter();
+
+        void writeLine(const std::string& line);
+        void writeRecord(const Json::Value& record);
+        // Adds "records" (the number of records written) to summary, writes it and flushes the stream
+        void writeSummary(const Json::Value& summary = Json::Value(Json::objectValue));
+        void flush();
+        inline uint64_t getRecordCount() const { return _recordCount; }
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_NDJSONWRITER_HPP_ */
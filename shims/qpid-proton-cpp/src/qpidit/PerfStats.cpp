@@ -0,0 +1,131 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/PerfStats.hpp"
+
+#include <cerrno>
+#include <sys/resource.h>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+
+    // static
+    const std::string PerfStats::s_endMarkerSubject("qpidit.end");
+    // static
+    const std::string PerfStats::s_sendTimeProperty("qpidit.sendTimeNs");
+    // static
+    const std::string PerfStats::s_endMarkerLinksProperty("qpidit.endMarkerLinks");
+    // static
+    const std::string PerfStats::s_endMarkerMsgsProperty("qpidit.endMarkerMsgs");
+
+    PerfStats::PerfStats() :
+                    _msgCount(0),
+                    _byteCount(0),
+                    _started(false),
+                    _stopped(false),
+                    _startWall(),
+                    _startCpu(),
+                    _stopWall(),
+                    _stopCpu()
+    {}
+
+    PerfStats::~PerfStats() {}
+
+    void PerfStats::start() {
+        _startCpu = now(CLOCK_PROCESS_CPUTIME_ID);
+        _startWall = now(CLOCK_MONOTONIC);
+        _started = true;
+        _stopped = false;
+    }
+
+    void PerfStats::stop() {
+        _stopWall = now(CLOCK_MONOTONIC);
+        _stopCpu = now(CLOCK_PROCESS_CPUTIME_ID);
+        _stopped = true;
+    }
+
+    double PerfStats::elapsedSeconds() const {
+        if (!_started) return 0.0;
+        return diffSeconds(_startWall, _stopped ? _stopWall : now(CLOCK_MONOTONIC));
+    }
+
+    double PerfStats::cpuSeconds() const {
+        if (!_started) return 0.0;
+        return diffSeconds(_startCpu, _stopped ? _stopCpu : now(CLOCK_PROCESS_CPUTIME_ID));
+    }
+
+    Json::Value PerfStats::toJson() const {
+        const double elapsed = elapsedSeconds();
+        Json::Value stats(Json::objectValue);
+        stats["messages"] = Json::UInt64(_msgCount);
+        stats["bytes"] = Json::UInt64(_byteCount);
+        stats["elapsedSeconds"] = elapsed;
+        stats["cpuSeconds"] = cpuSeconds();
+        stats["msgsPerSec"] = elapsed > 0.0 ? _msgCount / elapsed : 0.0;
+        stats["mbPerSec"] = elapsed > 0.0 ? _byteCount / elapsed / (1024 * 1024) : 0.0;
+        // Monotonic times let a harness measure from one process's start to another's stop
+        if (_started) {
+            stats["startMonotonicNs"] = Json::Int64(toNs(_startWall));
+        }
+        if (_stopped) {
+            stats["stopMonotonicNs"] = Json::Int64(toNs(_stopWall));
+        }
+        stats["peakRssKb"] = Json::UInt64(peakRssKb());
+        return stats;
+    }
+
+    // static
+    int64_t PerfStats::monotonicNs() {
+        return toNs(now(CLOCK_MONOTONIC));
+    }
+
+    // static
+    uint64_t PerfStats::peakRssKb() {
+        struct rusage usage;
+        if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+            throw qpidit::ErrnoError("getrusage", errno);
+        }
+        return usage.ru_maxrss; // kB on Linux
+    }
+
+    // protected
+
+    // static
+    double PerfStats::diffSeconds(const struct timespec& from, const struct timespec& to) {
+        return (to.tv_sec - from.tv_sec) + (to.tv_nsec - from.tv_nsec) / 1e9;
+    }
+
+    // static
+    int64_t PerfStats::toNs(const struct timespec& ts) {
+        return int64_t(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    // static
+    struct timespec PerfStats::now(clockid_t clockId) {
+        struct timespec ts;
+        if (::clock_gettime(clockId, &ts) != 0) {
+            throw qpidit::ErrnoError("clock_gettime", errno);
+        }
+        return ts;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,83 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_PERFSTATS_HPP_
+#define SRC_QPIDIT_PERFSTATS_HPP_
+
+#include <json/value.h>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+namespace qpidit
+{
+
+    /*
+     * Message and byte counts over a measured interval, timed by both the monotonic
+     * clock (elapsed) and the process CPU clock. Used by shim benchmark modes.
+     */
+    class PerfStats
+    {
+    public:
+        static const std::string s_endMarkerSubject; // Subject of the message ending a timed benchmark run
+        static const std::string s_sendTimeProperty; // Application property holding the sender's monotonicNs() at send
+        static const std::string s_endMarkerLinksProperty; // End marker property: number of sender links, each sends one
+        static const std::string s_endMarkerMsgsProperty; // End marker property: messages its link sent before it
+
+    protected:
+        uint64_t _msgCount;
+        uint64_t _byteCount;
+        bool _started;
+        bool _stopped;
+        struct timespec _startWall;
+        struct timespec _startCpu;
+        struct timespec _stopWall;
+        struct timespec _stopCpu;
+
+    public:
+        PerfStats();
+        virtual ~PerfStats();
+
+        void start();
+        void stop();
+        inline bool isStarted() const { return _started; }
+        inline bool isStopped() const { return _stopped; }
+        inline void add(uint64_t msgs, uint64_t bytes) { _msgCount += msgs; _byteCount += bytes; }
+
+        // Up to the time stop() was called, or up to now if still running
+        double elapsedSeconds() const;
+        double cpuSeconds() const;
+        Json::Value toJson() const;
+
+        // CLOCK_MONOTONIC in nanoseconds, comparable between processes on the same host
+        static int64_t monotonicNs();
+        // Peak resident set size of this process so far
+        static uint64_t peakRssKb();
+
+    protected:
+        static double diffSeconds(const struct timespec& from, const struct timespec& to);
+        static int64_t toNs(const struct timespec& ts);
+        static struct timespec now(clockid_t clockId);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_PERFSTATS_HPP_ */
@@ -0,0 +1,56 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/PnData.hpp"
+
+#include <proton/value.hpp>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+
+    PnData::PnData(const proton::value& v) : proton::codec::decoder(v) {}
+
+    PnData::~PnData() {}
+
+    pn_data_t* PnData::pnData() const {
+        return pn_object();
+    }
+
+    // static
+    size_t PnData::encodedSize(const proton::value& v) {
+        if (v.empty()) return 0;
+        const ssize_t size = ::pn_data_encoded_size(PnData(v).pnData());
+        return size < 0 ? 0 : size;
+    }
+
+    // static
+    // Decodes straight into the proton-c data underlying v, without building a value to copy in
+    void PnData::decode(proton::value& v, const char* bytes, size_t size) {
+        v.clear();
+        const ssize_t decodedSize = ::pn_data_decode(PnData(v).pnData(), bytes, size);
+        if (decodedSize != ssize_t(size)) {
+            throw qpidit::ArgumentError(MSG("PnData::decode: pn_data_decode() returned " << decodedSize << " for "
+                                            << size << " bytes"));
+        }
+    }
+
+} // namespace qpidit
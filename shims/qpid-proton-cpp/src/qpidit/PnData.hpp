@@ -0,0 +1,51 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_PNDATA_HPP_
+#define SRC_QPIDIT_PNDATA_HPP_
+
+#include <proton/codec/decoder.hpp>
+#include <proton/codec.h>
+
+namespace qpidit
+{
+
+    /*
+     * Gives direct access to the proton-c data underlying a proton::value, so that
+     * the value can be inspected in place without copying it out.
+     */
+    class PnData : public proton::codec::decoder
+    {
+    public:
+        explicit PnData(const proton::value& v);
+        virtual ~PnData();
+
+        pn_data_t* pnData() const;
+
+        // Size of v in AMQP wire format, found without encoding it
+        static size_t encodedSize(const proton::value& v);
+        // Replaces v with the single value in AMQP wire format in bytes
+        static void decode(proton::value& v, const char* bytes, size_t size);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_PNDATA_HPP_ */
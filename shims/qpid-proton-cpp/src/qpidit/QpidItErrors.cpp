@@ -71,6 +71,23 @@ namespace qpidit
 
     IncorrectJmsMapKeyPrefixError::~IncorrectJmsMapKeyPrefixError() throw() {}
 
+    // --- IncorrectMessageBodyContentError ---
+
+    IncorrectMessageBodyContentError::IncorrectMessageBodyContentError(const std::string& context, uint64_t offset) :
+                    std::runtime_error(MSG(context << ": Incorrect content found in message body at byte " << offset))
+    {}
+
+    IncorrectMessageBodyContentError::~IncorrectMessageBodyContentError() throw() {}
+
+    // --- IncorrectMessageBodyCrcError ---
+
+    IncorrectMessageBodyCrcError::IncorrectMessageBodyCrcError(const std::string& context, uint32_t expected, uint32_t found) :
+                    std::runtime_error(MSG(context << ": Incorrect CRC32C of message body: expected: 0x" << std::hex
+                                    << expected << "; found 0x" << found))
+    {}
+
+    IncorrectMessageBodyCrcError::~IncorrectMessageBodyCrcError() throw() {}
+
     // --- IncorrectMessageBodyLengthError ---
 
     IncorrectMessageBodyLengthError::IncorrectMessageBodyLengthError(const std::string& context, int expected, int found) :
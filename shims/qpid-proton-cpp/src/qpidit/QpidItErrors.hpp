@@ -77,6 +77,20 @@ namespace qpidit
         virtual ~IncorrectJmsMapKeyPrefixError() throw();
     };
 
+    class IncorrectMessageBodyContentError: public std::runtime_error
+    {
+    public:
+        IncorrectMessageBodyContentError(const std::string& context, uint64_t offset);
+        virtual ~IncorrectMessageBodyContentError() throw();
+    };
+
+    class IncorrectMessageBodyCrcError: public std::runtime_error
+    {
+    public:
+        IncorrectMessageBodyCrcError(const std::string& context, uint32_t expected, uint32_t found);
+        virtual ~IncorrectMessageBodyCrcError() throw();
+    };
+
     class IncorrectMessageBodyLengthError: public std::runtime_error
     {
     public:
@@ -0,0 +1,104 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/ShimOptions.hpp"
+
+#include <cstdlib>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+
+    ShimOptions::ShimOptions() : _optionMap(), _usedOptions() {}
+
+    ShimOptions::ShimOptions(int argc, char** argv, int firstOptionIndex) : _optionMap(), _usedOptions() {
+        for (int i=firstOptionIndex; i<argc; ++i) {
+            const std::string arg(argv[i]);
+            if (arg.size() < 3 || arg.compare(0, 2, "--") != 0) {
+                throw qpidit::ArgumentError(MSG("Unexpected argument \"" << arg << "\", expected \"--<option>\""));
+            }
+            std::string val;
+            if (i+1 < argc && std::string(argv[i+1]).compare(0, 2, "--") != 0) {
+                val = argv[++i];
+            }
+            _optionMap[arg.substr(2)] = val;
+        }
+    }
+
+    ShimOptions::~ShimOptions() {}
+
+    bool ShimOptions::hasOption(const std::string& name) const {
+        return find(name) != 0;
+    }
+
+    bool ShimOptions::getFlag(const std::string& name) const {
+        const std::string* val = find(name);
+        if (val == 0) return false;
+        if (!val->empty()) {
+            throw qpidit::ArgumentError(MSG("Option \"--" << name << "\" is a flag and takes no value, found \"" << *val << "\""));
+        }
+        return true;
+    }
+
+    std::string ShimOptions::getString(const std::string& name, const std::string& defaultValue) const {
+        const std::string* val = find(name);
+        return val == 0 ? defaultValue : *val;
+    }
+
+    uint64_t ShimOptions::getUInt(const std::string& name, uint64_t defaultValue) const {
+        const std::string* val = find(name);
+        if (val == 0) return defaultValue;
+        char* end = 0;
+        const uint64_t uval = std::strtoull(val->c_str(), &end, 0);
+        if (val->empty() || *end != '\0' || (*val)[0] == '-') {
+            throw qpidit::ArgumentError(MSG("Option \"--" << name << "\": invalid unsigned integer \"" << *val << "\""));
+        }
+        return uval;
+    }
+
+    double ShimOptions::getDouble(const std::string& name, double defaultValue) const {
+        const std::string* val = find(name);
+        if (val == 0) return defaultValue;
+        char* end = 0;
+        const double dval = std::strtod(val->c_str(), &end);
+        if (val->empty() || *end != '\0') {
+            throw qpidit::ArgumentError(MSG("Option \"--" << name << "\": invalid number \"" << *val << "\""));
+        }
+        return dval;
+    }
+
+    void ShimOptions::checkAllUsed() const {
+        for (std::map<std::string, std::string>::const_iterator i=_optionMap.begin(); i!=_optionMap.end(); ++i) {
+            if (_usedOptions.find(i->first) == _usedOptions.end()) {
+                throw qpidit::ArgumentError(MSG("Unknown option \"--" << i->first << "\""));
+            }
+        }
+    }
+
+    // protected
+
+    const std::string* ShimOptions::find(const std::string& name) const {
+        _usedOptions.insert(name);
+        std::map<std::string, std::string>::const_iterator i = _optionMap.find(name);
+        return i == _optionMap.end() ? 0 : &i->second;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,64 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_SHIMOPTIONS_HPP_
+#define SRC_QPIDIT_SHIMOPTIONS_HPP_
+
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <string>
+
+namespace qpidit
+{
+
+    /*
+     * Optional shim arguments which follow the fixed positional arguments, in the form
+     * "--name value" or "--name" (flag). Apart from --stream, the test harness does not pass
+     * these, so every option must have a default which gives the original correctness-test behavior.
+     */
+    class ShimOptions
+    {
+    protected:
+        std::map<std::string, std::string> _optionMap;
+        mutable std::set<std::string> _usedOptions;
+
+    public:
+        ShimOptions();
+        ShimOptions(int argc, char** argv, int firstOptionIndex);
+        virtual ~ShimOptions();
+
+        bool hasOption(const std::string& name) const;
+        bool getFlag(const std::string& name) const;
+        std::string getString(const std::string& name, const std::string& defaultValue) const;
+        uint64_t getUInt(const std::string& name, uint64_t defaultValue) const;
+        double getDouble(const std::string& name, double defaultValue) const;
+
+        // Throws ArgumentError if an option was supplied which no getter has asked for
+        void checkAllUsed() const;
+
+    protected:
+        const std::string* find(const std::string& name) const;
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_SHIMOPTIONS_HPP_ */
@@ -0,0 +1,88 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/StreamedMessage.hpp"
+
+#include <algorithm>
+#include <proton/delivery.h>
+#include <proton/link.h>
+#include <proton/sender.hpp>
+#include <proton/session.h>
+
+namespace
+{
+    // Gives access to the proton-c link underlying a proton::sender
+    class RawSender : public proton::sender
+    {
+    public:
+        RawSender(const proton::sender& s) : proton::sender(s) {}
+        pn_link_t* pnLink() const { return pn_object(); }
+    };
+}
+
+namespace qpidit
+{
+
+    StreamedMessage::Source::~Source() {}
+
+    const char* StreamedMessage::Source::peek(size_t /*size*/) {
+        return 0;
+    }
+
+    StreamedMessage::StreamedMessage(Source* source, size_t chunkSize, size_t maxBufferedBytes) :
+                    _source(source),
+                    _chunk(chunkSize),
+                    _maxBufferedBytes(maxBufferedBytes),
+                    _bytesWritten(0)
+    {}
+
+    StreamedMessage::~StreamedMessage() {}
+
+    bool StreamedMessage::start(proton::sender& s, uint64_t deliveryTag) {
+        pn_delivery(RawSender(s).pnLink(), pn_dtag(reinterpret_cast<const char*>(&deliveryTag), sizeof(deliveryTag)));
+        return write(s);
+    }
+
+    // The delivery stays current on the link, and so open for more bytes, until pn_link_advance()
+    bool StreamedMessage::write(proton::sender& s) {
+        pn_link_t* link = RawSender(s).pnLink();
+        pn_session_t* session = pn_link_session(link);
+        const uint64_t totalBytes = _source->size();
+        while (_bytesWritten < totalBytes && pn_session_outgoing_bytes(session) < _maxBufferedBytes) {
+            const size_t n = std::min(uint64_t(_chunk.size()), totalBytes - _bytesWritten);
+            const char* bytes = _source->peek(n);
+            if (bytes == 0) {
+                _source->read(_chunk.data(), n);
+                bytes = _chunk.data();
+            }
+            pn_link_send(link, bytes, n);
+            _bytesWritten += n;
+        }
+        if (_bytesWritten < totalBytes) return false;
+        pn_delivery_t* d = pn_link_current(link);
+        pn_link_advance(link);
+        if (d != 0 && pn_link_snd_settle_mode(link) == PN_SND_SETTLED) {
+            pn_delivery_settle(d);
+        }
+        return true;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,77 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_STREAMEDMESSAGE_HPP_
+#define SRC_QPIDIT_STREAMEDMESSAGE_HPP_
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace proton {
+    class sender;
+}
+
+namespace qpidit
+{
+
+    /*
+     * A message sent as a single multi-frame delivery, written to the underlying proton-c link a
+     * chunk at a time, so that the whole encoded message is never held in memory. Chunks are only
+     * written while the session has fewer than maxBufferedBytes waiting for the transport; the
+     * caller calls write() again once the transport has had a chance to drain them.
+     */
+    class StreamedMessage
+    {
+    public:
+        // Supplies the encoded message bytes in order
+        class Source
+        {
+        public:
+            virtual ~Source();
+            virtual uint64_t size() const = 0;
+            virtual void read(char* buf, size_t size) = 0;
+            // If the next size bytes are already held contiguously in memory, moves past them and returns
+            // where they are, so they are written without a copy; otherwise returns 0 and they are read()
+            virtual const char* peek(size_t size);
+        };
+
+    protected:
+        std::unique_ptr<Source> _source;
+        std::vector<char> _chunk;
+        const size_t _maxBufferedBytes;
+        uint64_t _bytesWritten;
+
+    public:
+        StreamedMessage(Source* source, size_t chunkSize, size_t maxBufferedBytes);
+        virtual ~StreamedMessage();
+
+        // Creates the delivery on s, then writes as much as the session will buffer
+        bool start(proton::sender& s, uint64_t deliveryTag);
+        // Writes as much as the session will buffer, returns true once the whole message is written
+        bool write(proton::sender& s);
+        inline uint64_t size() const { return _source->size(); }
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_STREAMEDMESSAGE_HPP_ */
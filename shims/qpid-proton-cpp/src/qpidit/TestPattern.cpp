@@ -0,0 +1,97 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/TestPattern.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <qpidit/Crc32c.hpp>
+
+namespace qpidit
+{
+
+    namespace
+    {
+        // Data is compared against this block a chunk at a time, starting at the block offset that lines up
+        // with the pattern, so a chunk may be up to one period shorter than the block
+        const size_t s_verifyChunkSize = 64 * 1024;
+
+        struct ReferenceBlock
+        {
+            char data[s_verifyChunkSize + TestPattern::s_period];
+            ReferenceBlock() { TestPattern::fill(data, sizeof(data)); }
+        };
+
+        const char* referenceBlock() {
+            static const ReferenceBlock block;
+            return block.data;
+        }
+    }
+
+    const size_t TestPattern::s_period;
+    const std::string TestPattern::s_crc32cAnnotationKey("x-qpidit-crc32c");
+    const std::string TestPattern::s_payloadCrc32cAnnotationKey("x-qpidit-payload-crc32c");
+
+    // static
+    // One period is written a byte at a time, then the filled prefix (always a whole number of periods)
+    // is doubled by memcpy until buf is full.
+    void TestPattern::fill(char* buf, size_t size, uint64_t patternOffset) {
+        size_t filled = std::min(size, s_period);
+        for (size_t i=0; i<filled; ++i) {
+            buf[i] = char('a' + (patternOffset + i) % s_period);
+        }
+        while (filled < size) {
+            const size_t n = std::min(filled, size - filled);
+            std::memcpy(buf + filled, buf, n);
+            filled += n;
+        }
+    }
+
+    // static
+    size_t TestPattern::verify(const char* data, size_t size, uint64_t patternOffset) {
+        const char* block = referenceBlock();
+        size_t verified = 0;
+        while (verified < size) {
+            const char* expected = block + (patternOffset + verified) % s_period;
+            const size_t n = std::min(s_verifyChunkSize, size - verified);
+            if (std::memcmp(data + verified, expected, n) != 0) {
+                size_t i = 0;
+                while (data[verified + i] == expected[i]) ++i;
+                return verified + i;
+            }
+            verified += n;
+        }
+        return size;
+    }
+
+    // static
+    uint32_t TestPattern::crc32c(uint64_t size, uint64_t patternOffset) {
+        const char* block = referenceBlock();
+        uint32_t crc = 0;
+        for (uint64_t done=0; done<size; ) {
+            const size_t n = std::min(uint64_t(s_verifyChunkSize), size - done);
+            crc = Crc32c::extend(crc, block + (patternOffset + done) % s_period, n);
+            done += n;
+        }
+        return crc;
+    }
+
+} // namespace qpidit
@@ -0,0 +1,56 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_TESTPATTERN_HPP_
+#define SRC_QPIDIT_TESTPATTERN_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace qpidit
+{
+
+    /*
+     * The repeating "abc...z" byte pattern that large content tests send in their bodies and elements.
+     * The pattern offset is the position in the pattern of the first byte, so that a body can be
+     * generated or checked in pieces. A sender may also attach the CRC32C of each body (or of each list or
+     * map element) as a message annotation, which receivers check alongside the pattern. A body which
+     * is not the pattern, such as one sent from a payload file, carries its CRC32C under
+     * s_payloadCrc32cAnnotationKey instead, and receivers check only that.
+     */
+    class TestPattern
+    {
+    public:
+        static const size_t s_period = 26;
+        static const std::string s_crc32cAnnotationKey;
+        static const std::string s_payloadCrc32cAnnotationKey;
+
+        static void fill(char* buf, size_t size, uint64_t patternOffset = 0);
+        // Returns the index of the first byte of data that differs from the pattern, or size if none does
+        static size_t verify(const char* data, size_t size, uint64_t patternOffset = 0);
+        // CRC32C of size bytes of the pattern, found without generating them
+        static uint32_t crc32c(uint64_t size, uint64_t patternOffset = 0);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_TESTPATTERN_HPP_ */
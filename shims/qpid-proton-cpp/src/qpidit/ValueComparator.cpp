@@ -0,0 +1,367 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/ValueComparator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <proton/value.hpp>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/PnData.hpp>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+
+    ValueComparator::ValueComparator() : _failure(), _path() {}
+
+    ValueComparator::~ValueComparator() {}
+
+    bool ValueComparator::equal(const proton::value& received, const proton::value& expected) {
+        _failure.clear();
+        _path.clear();
+        if (received.empty() || expected.empty()) {
+            if (received.empty() && expected.empty()) return true;
+            return fail(received.empty() ? "received no value" : "received a value, expected none");
+        }
+        PnData receivedData(received);
+        PnData expectedData(expected);
+        pn_data_t* r = receivedData.pnData();
+        pn_data_t* e = expectedData.pnData();
+        pn_data_rewind(r);
+        pn_data_rewind(e);
+        pn_data_next(r);
+        pn_data_next(e);
+        return equalNodes(r, e);
+    }
+
+    std::string ValueComparator::failure() const {
+        if (_path.empty()) return _failure;
+        std::ostringstream oss;
+        oss << "at ";
+        for (std::vector<std::string>::const_reverse_iterator i = _path.crbegin(); i != _path.crend(); ++i) {
+            oss << *i;
+        }
+        oss << ": " << _failure;
+        return oss.str();
+    }
+
+    // protected
+
+    bool ValueComparator::equalNodes(pn_data_t* r, pn_data_t* e) {
+        const pn_atom_t receivedAtom = pn_data_get_atom(r);
+        const pn_atom_t expectedAtom = pn_data_get_atom(e);
+        if (receivedAtom.type != expectedAtom.type) {
+            return fail(MSG("type differs: received " << atomString(receivedAtom) << ", expected "
+                            << atomString(expectedAtom)));
+        }
+        switch (expectedAtom.type) {
+        case PN_DESCRIBED:
+            return equalChildren(r, e, 2); // descriptor, value
+        case PN_LIST: {
+            const std::size_t count = pn_data_get_list(e);
+            if (pn_data_get_list(r) != count) {
+                return fail(MSG("list size differs: received " << pn_data_get_list(r) << ", expected " << count));
+            }
+            return equalChildren(r, e, count);
+        }
+        case PN_ARRAY: {
+            const std::size_t count = pn_data_get_array(e);
+            const pn_type_t elementType = pn_data_get_array_type(e);
+            const bool described = pn_data_is_array_described(e);
+            if (pn_data_get_array(r) != count || pn_data_get_array_type(r) != elementType
+                    || pn_data_is_array_described(r) != described) {
+                return fail(MSG("array differs: received " << pn_data_get_array(r) << " "
+                                << AmqpTypes::typeName(proton::type_id(pn_data_get_array_type(r)))
+                                << (pn_data_is_array_described(r) ? " described" : "") << " elements, expected "
+                                << count << " " << AmqpTypes::typeName(proton::type_id(elementType))
+                                << (described ? " described" : "") << " elements"));
+            }
+            return equalChildren(r, e, described ? count + 1 : count); // A described array's descriptor comes first
+        }
+        case PN_MAP: {
+            const std::size_t count = pn_data_get_map(e);
+            if (pn_data_get_map(r) != count) {
+                return fail(MSG("map size differs: received " << pn_data_get_map(r) / 2 << " entries, expected "
+                                << count / 2 << " entries"));
+            }
+            return equalMapEntries(r, e, count);
+        }
+        default:
+            if (compareAtoms(receivedAtom, expectedAtom) != 0) {
+                return fail(MSG("value differs: received " << atomString(receivedAtom) << ", expected "
+                                << atomString(expectedAtom)));
+            }
+            return true;
+        }
+    }
+
+    bool ValueComparator::equalChildren(pn_data_t* r, pn_data_t* e, std::size_t count) {
+        pn_data_enter(r);
+        pn_data_enter(e);
+        for (std::size_t i = 0; i < count; ++i) {
+            pn_data_next(r);
+            pn_data_next(e);
+            if (!equalNodes(r, e)) return failPath(MSG("[" << i << "]"));
+        }
+        pn_data_exit(r);
+        pn_data_exit(e);
+        return true;
+    }
+
+    // count is the number of keys and values, as pn_data_get_map() gives it
+    bool ValueComparator::equalMapEntries(pn_data_t* r, pn_data_t* e, std::size_t count) {
+        pn_data_enter(r);
+        pn_data_enter(e);
+        for (std::size_t i = 0; i < count; i += 2) {
+            const pn_handle_t receivedPoint = pn_data_point(r);
+            const pn_handle_t expectedPoint = pn_data_point(e);
+            pn_data_next(r);
+            pn_data_next(e);
+            if (compareNodes(r, e) != 0) {
+                // The maps are in different orders from here on, so match the remaining entries by key
+                pn_data_restore(r, receivedPoint);
+                pn_data_restore(e, expectedPoint);
+                if (!equalMapEntriesIndexed(r, e, count - i)) return false;
+                break;
+            }
+            const pn_atom_t key = pn_data_get_atom(r);
+            pn_data_next(r);
+            pn_data_next(e);
+            if (!equalNodes(r, e)) return failPath(MSG("{" << atomString(key) << "}"));
+        }
+        pn_data_exit(r);
+        pn_data_exit(e);
+        return true;
+    }
+
+    // Both cursors are just before the first key to match
+    bool ValueComparator::equalMapEntriesIndexed(pn_data_t* r, pn_data_t* e, std::size_t count) {
+        const std::size_t entries = count / 2;
+        KeyIndexEntry_t indexBuffer[s_indexBufferSize];
+        std::vector<KeyIndexEntry_t> largeIndex;
+        KeyIndexEntry_t* index = indexBuffer;
+        if (entries > s_indexBufferSize) {
+            largeIndex.resize(entries);
+            index = largeIndex.data();
+        }
+        KeyIndexEntry_t* const indexEnd = index + entries;
+        for (KeyIndexEntry_t* i = index; i != indexEnd; ++i) {
+            pn_data_next(e);
+            i->key = pn_data_get_atom(e);
+            i->handle = pn_data_point(e);
+            i->matched = false;
+            pn_data_next(e);
+        }
+        std::sort(index, indexEnd, lessKey);
+
+        for (std::size_t i = 0; i < entries; ++i) {
+            pn_data_next(r);
+            KeyIndexEntry_t receivedKey;
+            receivedKey.key = pn_data_get_atom(r);
+            // Compound keys of a type all index alike, so each candidate is compared in full
+            const std::pair<KeyIndexEntry_t*, KeyIndexEntry_t*> candidates = std::equal_range(index, indexEnd, receivedKey, lessKey);
+            KeyIndexEntry_t* match = indexEnd;
+            for (KeyIndexEntry_t* c = candidates.first; c != candidates.second && match == indexEnd; ++c) {
+                if (c->matched) continue;
+                pn_data_restore(e, c->handle);
+                if (compareNodes(r, e) == 0) match = c;
+            }
+            if (match == indexEnd) {
+                return fail(MSG("map key " << atomString(receivedKey.key) << " not found in expected"));
+            }
+            match->matched = true;
+            pn_data_restore(e, match->handle);
+            pn_data_next(r);
+            pn_data_next(e);
+            if (!equalNodes(r, e)) return failPath(MSG("{" << atomString(receivedKey.key) << "}"));
+        }
+        return true;
+    }
+
+    bool ValueComparator::fail(const std::string& failure) {
+        _failure = failure;
+        return false;
+    }
+
+    bool ValueComparator::failPath(const std::string& segment) {
+        _path.push_back(segment);
+        return false;
+    }
+
+    // static
+    // Compound values compare element by element in order, maps included
+    int ValueComparator::compareNodes(pn_data_t* a, pn_data_t* b) {
+        const pn_atom_t aAtom = pn_data_get_atom(a);
+        const pn_atom_t bAtom = pn_data_get_atom(b);
+        if (aAtom.type != bAtom.type) return compareNumbers(aAtom.type, bAtom.type);
+        int order = compareAtoms(aAtom, bAtom);
+        if (order != 0) return order;
+        switch (aAtom.type) {
+        case PN_ARRAY:
+            order = compareNumbers(pn_data_get_array_type(a), pn_data_get_array_type(b));
+            if (order != 0) return order;
+            // fall through
+        case PN_DESCRIBED:
+        case PN_LIST:
+        case PN_MAP: {
+            pn_data_enter(a);
+            pn_data_enter(b);
+            bool aNext = pn_data_next(a);
+            bool bNext = pn_data_next(b);
+            while (order == 0 && aNext && bNext) {
+                order = compareNodes(a, b);
+                aNext = pn_data_next(a);
+                bNext = pn_data_next(b);
+            }
+            if (order == 0) order = compareNumbers(aNext, bNext);
+            pn_data_exit(a);
+            pn_data_exit(b);
+            return order;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    // static
+    int ValueComparator::compareAtoms(const pn_atom_t& a, const pn_atom_t& b) {
+        switch (a.type) {
+        case PN_BOOL: return compareNumbers(a.u.as_bool, b.u.as_bool);
+        case PN_UBYTE: return compareNumbers(a.u.as_ubyte, b.u.as_ubyte);
+        case PN_USHORT: return compareNumbers(a.u.as_ushort, b.u.as_ushort);
+        case PN_UINT: return compareNumbers(a.u.as_uint, b.u.as_uint);
+        case PN_ULONG: return compareNumbers(a.u.as_ulong, b.u.as_ulong);
+        case PN_BYTE: return compareNumbers(a.u.as_byte, b.u.as_byte);
+        case PN_SHORT: return compareNumbers(a.u.as_short, b.u.as_short);
+        case PN_INT: return compareNumbers(a.u.as_int, b.u.as_int);
+        case PN_LONG: return compareNumbers(a.u.as_long, b.u.as_long);
+        case PN_CHAR: return compareNumbers(a.u.as_char, b.u.as_char);
+        case PN_TIMESTAMP: return compareNumbers(a.u.as_timestamp, b.u.as_timestamp);
+        case PN_FLOAT: return compareFloats(a.u.as_float, b.u.as_float);
+        case PN_DOUBLE: return compareFloats(a.u.as_double, b.u.as_double);
+        case PN_DECIMAL32: return compareNumbers(a.u.as_decimal32, b.u.as_decimal32);
+        case PN_DECIMAL64: return compareNumbers(a.u.as_decimal64, b.u.as_decimal64);
+        case PN_DECIMAL128:
+            return compareBytes(a.u.as_decimal128.bytes, sizeof(a.u.as_decimal128.bytes),
+                                b.u.as_decimal128.bytes, sizeof(b.u.as_decimal128.bytes));
+        case PN_UUID:
+            return compareBytes(a.u.as_uuid.bytes, sizeof(a.u.as_uuid.bytes),
+                                b.u.as_uuid.bytes, sizeof(b.u.as_uuid.bytes));
+        case PN_BINARY:
+        case PN_STRING:
+        case PN_SYMBOL:
+            return compareBytes(a.u.as_bytes.start, a.u.as_bytes.size, b.u.as_bytes.start, b.u.as_bytes.size);
+        default: // PN_NULL and compound types
+            return 0;
+        }
+    }
+
+    // static
+    int ValueComparator::compareBytes(const char* a, std::size_t aSize, const char* b, std::size_t bSize) {
+        const int order = std::memcmp(a, b, std::min(aSize, bSize));
+        if (order != 0) return order < 0 ? -1 : 1;
+        return compareNumbers(aSize, bSize);
+    }
+
+    // static
+    // NaN orders after every number, and equal to itself
+    int ValueComparator::compareFloats(double a, double b) {
+        const bool aNan = std::isnan(a);
+        const bool bNan = std::isnan(b);
+        if (aNan || bNan) return compareNumbers(aNan, bNan);
+        return compareNumbers(a, b);
+    }
+
+    // static
+    bool ValueComparator::lessKey(const KeyIndexEntry_t& a, const KeyIndexEntry_t& b) {
+        if (a.key.type != b.key.type) return a.key.type < b.key.type;
+        return compareAtoms(a.key, b.key) < 0;
+    }
+
+    // static
+    // Prints as type(value), or just the type for null and compound types
+    void ValueComparator::printAtom(std::ostream& out, const pn_atom_t& atom) {
+        out << (atom.type == PN_DESCRIBED ? std::string("described") : AmqpTypes::typeName(proton::type_id(atom.type)));
+        switch (atom.type) {
+        case PN_BOOL: out << (atom.u.as_bool ? "(true)" : "(false)"); break;
+        case PN_UBYTE: out << "(" << unsigned(atom.u.as_ubyte) << ")"; break;
+        case PN_USHORT: out << "(" << atom.u.as_ushort << ")"; break;
+        case PN_UINT: out << "(" << atom.u.as_uint << ")"; break;
+        case PN_ULONG: out << "(" << atom.u.as_ulong << ")"; break;
+        case PN_BYTE: out << "(" << int(atom.u.as_byte) << ")"; break;
+        case PN_SHORT: out << "(" << atom.u.as_short << ")"; break;
+        case PN_INT: out << "(" << atom.u.as_int << ")"; break;
+        case PN_LONG: out << "(" << atom.u.as_long << ")"; break;
+        case PN_TIMESTAMP: out << "(" << atom.u.as_timestamp << ")"; break;
+        case PN_CHAR: out << "(U+" << std::hex << std::uppercase << atom.u.as_char << ")"; break;
+        case PN_FLOAT: out << "(" << std::setprecision(9) << atom.u.as_float << ")"; break;
+        case PN_DOUBLE: out << "(" << std::setprecision(17) << atom.u.as_double << ")"; break;
+        case PN_DECIMAL32: out << "(0x" << std::hex << atom.u.as_decimal32 << ")"; break;
+        case PN_DECIMAL64: out << "(0x" << std::hex << atom.u.as_decimal64 << ")"; break;
+        case PN_DECIMAL128:
+        case PN_UUID: {
+            const char* bytes = atom.type == PN_UUID ? atom.u.as_uuid.bytes : atom.u.as_decimal128.bytes;
+            out << "(0x" << std::hex << std::setfill('0');
+            for (std::size_t i = 0; i < sizeof(atom.u.as_uuid.bytes); ++i) {
+                out << std::setw(2) << unsigned(static_cast<unsigned char>(bytes[i]));
+            }
+            out << ")";
+            break;
+        }
+        case PN_BINARY:
+        case PN_STRING:
+        case PN_SYMBOL:
+            out << "(";
+            printBytes(out, atom.u.as_bytes);
+            out << ")";
+            break;
+        default:
+            break;
+        }
+    }
+
+    // static
+    // Quoted, with anything unprintable as a \xNN escape
+    void ValueComparator::printBytes(std::ostream& out, const pn_bytes_t& bytes) {
+        out << "\"" << std::hex << std::setfill('0');
+        for (std::size_t i = 0; i < bytes.size; ++i) {
+            const unsigned char c = static_cast<unsigned char>(bytes.start[i]);
+            if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+                out << c;
+            } else {
+                out << "\\x" << std::setw(2) << unsigned(c);
+            }
+        }
+        out << "\"";
+    }
+
+    // static
+    std::string ValueComparator::atomString(const pn_atom_t& atom) {
+        std::ostringstream oss;
+        printAtom(oss, atom);
+        return oss.str();
+    }
+
+} // namespace qpidit
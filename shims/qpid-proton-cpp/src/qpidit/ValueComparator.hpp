@@ -0,0 +1,92 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_VALUECOMPARATOR_HPP_
+#define SRC_QPIDIT_VALUECOMPARATOR_HPP_
+
+#include <iosfwd>
+#include <proton/codec.h>
+#include <string>
+#include <vector>
+
+namespace proton {
+    class value;
+}
+
+namespace qpidit
+{
+
+    /*
+     * Compares two proton::values structurally, walking their proton-c data in lock-step without
+     * copying anything out of it. Types and values must match throughout, except that map entries
+     * may be in any order: they are compared in order until a key differs, and only then is the
+     * expected map indexed by key. The index is sorted in a fixed buffer, so nothing is allocated
+     * unless a map is larger than s_indexBufferSize entries or the values differ.
+     *
+     * Floating point values compare as numbers (so 0.0 equals -0.0), except that NaN equals NaN.
+     * When values differ, failure() gives the first difference and its path from the top of the value.
+     */
+    class ValueComparator
+    {
+    protected:
+        struct KeyIndexEntry_t {
+            pn_atom_t key;
+            pn_handle_t handle;
+            bool matched;
+        };
+        static const std::size_t s_indexBufferSize = 32;
+
+        std::string _failure;
+        std::vector<std::string> _path; // Innermost segment first, only built on failure
+    public:
+        ValueComparator();
+        virtual ~ValueComparator();
+
+        bool equal(const proton::value& received, const proton::value& expected);
+        std::string failure() const;
+    protected:
+        // Each compares the current nodes, leaving the cursors on them if equal
+        bool equalNodes(pn_data_t* r, pn_data_t* e);
+        bool equalChildren(pn_data_t* r, pn_data_t* e, std::size_t count);
+        bool equalMapEntries(pn_data_t* r, pn_data_t* e, std::size_t count);
+        bool equalMapEntriesIndexed(pn_data_t* r, pn_data_t* e, std::size_t count);
+        bool fail(const std::string& failure);
+        bool failPath(const std::string& segment);
+
+        // Orders values by type, then by value: quiet, and leaves both cursors where they were
+        static int compareNodes(pn_data_t* a, pn_data_t* b);
+        // Orders scalars of the same type; all compound atoms are equal
+        static int compareAtoms(const pn_atom_t& a, const pn_atom_t& b);
+        static int compareBytes(const char* a, std::size_t aSize, const char* b, std::size_t bSize);
+        static int compareFloats(double a, double b);
+        static bool lessKey(const KeyIndexEntry_t& a, const KeyIndexEntry_t& b);
+        static void printAtom(std::ostream& out, const pn_atom_t& atom);
+        static void printBytes(std::ostream& out, const pn_bytes_t& bytes);
+        static std::string atomString(const pn_atom_t& atom);
+
+        template<typename T> static int compareNumbers(T a, T b) {
+            return a < b ? -1 : (b < a ? 1 : 0);
+        }
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_VALUECOMPARATOR_HPP_ */
@@ -0,0 +1,170 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "qpidit/ValueHash.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <proton/value.hpp>
+#include <qpidit/PnData.hpp>
+
+namespace qpidit
+{
+
+    //static
+    uint64_t ValueHash::hash(const proton::value& v) {
+        if (v.empty()) return 0;
+        PnData pnData(v);
+        pn_data_t* data = pnData.pnData();
+        pn_data_rewind(data);
+        pn_data_next(data);
+        return hashNode(data);
+    }
+
+    //static
+    std::string ValueHash::hashString(const proton::value& v) {
+        std::ostringstream oss;
+        oss << std::hex << std::setw(16) << std::setfill('0') << hash(v);
+        return oss.str();
+    }
+
+    // protected
+
+    //static
+    // Hashes the current node, leaving the cursor on it
+    uint64_t ValueHash::hashNode(pn_data_t* data) {
+        const pn_atom_t atom = pn_data_get_atom(data);
+        const uint64_t h = mix(atom.type);
+        switch (atom.type) {
+        case PN_BOOL: return combine(h, atom.u.as_bool);
+        case PN_UBYTE: return combine(h, atom.u.as_ubyte);
+        case PN_USHORT: return combine(h, atom.u.as_ushort);
+        case PN_UINT: return combine(h, atom.u.as_uint);
+        case PN_ULONG: return combine(h, atom.u.as_ulong);
+        case PN_BYTE: return combine(h, static_cast<uint64_t>(int64_t(atom.u.as_byte)));
+        case PN_SHORT: return combine(h, static_cast<uint64_t>(int64_t(atom.u.as_short)));
+        case PN_INT: return combine(h, static_cast<uint64_t>(int64_t(atom.u.as_int)));
+        case PN_LONG: return combine(h, static_cast<uint64_t>(atom.u.as_long));
+        case PN_CHAR: return combine(h, atom.u.as_char);
+        case PN_TIMESTAMP: return combine(h, static_cast<uint64_t>(atom.u.as_timestamp));
+        case PN_FLOAT: return combine(h, hashFloat(atom.u.as_float));
+        case PN_DOUBLE: return combine(h, hashDouble(atom.u.as_double));
+        case PN_DECIMAL32: return combine(h, atom.u.as_decimal32);
+        case PN_DECIMAL64: return combine(h, atom.u.as_decimal64);
+        case PN_DECIMAL128: return hashBytes(h, atom.u.as_decimal128.bytes, sizeof(atom.u.as_decimal128.bytes));
+        case PN_UUID: return hashBytes(h, atom.u.as_uuid.bytes, sizeof(atom.u.as_uuid.bytes));
+        case PN_BINARY:
+        case PN_STRING:
+        case PN_SYMBOL:
+            return hashBytes(h, atom.u.as_bytes.start, atom.u.as_bytes.size);
+        case PN_DESCRIBED:
+            return hashChildren(data, h, 2); // descriptor, value
+        case PN_LIST: {
+            const std::size_t count = pn_data_get_list(data);
+            return hashChildren(data, combine(h, count), count);
+        }
+        case PN_ARRAY: {
+            const std::size_t count = pn_data_get_array(data);
+            const bool described = pn_data_is_array_described(data);
+            const uint64_t arrayHash = combine(combine(combine(h, count), pn_data_get_array_type(data)), described);
+            return hashChildren(data, arrayHash, described ? count + 1 : count); // A described array's descriptor comes first
+        }
+        case PN_MAP: {
+            const std::size_t count = pn_data_get_map(data);
+            return hashMapEntries(data, combine(h, count), count);
+        }
+        default: // PN_NULL
+            return h;
+        }
+    }
+
+    //static
+    // In order
+    uint64_t ValueHash::hashChildren(pn_data_t* data, uint64_t h, std::size_t count) {
+        pn_data_enter(data);
+        for (std::size_t i = 0; i < count; ++i) {
+            pn_data_next(data);
+            h = combine(h, hashNode(data));
+        }
+        pn_data_exit(data);
+        return h;
+    }
+
+    //static
+    // Each entry is hashed as an ordered key and value, and the entries are summed, which no order changes
+    uint64_t ValueHash::hashMapEntries(pn_data_t* data, uint64_t h, std::size_t count) {
+        uint64_t entriesSum = 0;
+        pn_data_enter(data);
+        for (std::size_t i = 0; i < count; i += 2) {
+            pn_data_next(data);
+            const uint64_t keyHash = hashNode(data);
+            pn_data_next(data);
+            entriesSum += combine(keyHash, hashNode(data));
+        }
+        pn_data_exit(data);
+        return combine(h, entriesSum);
+    }
+
+    //static
+    // FNV-1a, then combined with the size
+    uint64_t ValueHash::hashBytes(uint64_t h, const char* bytes, std::size_t size) {
+        uint64_t fnv = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < size; ++i) {
+            fnv = (fnv ^ static_cast<unsigned char>(bytes[i])) * 0x100000001b3ULL;
+        }
+        return combine(combine(h, size), fnv);
+    }
+
+    //static
+    uint64_t ValueHash::hashFloat(float f) {
+        if (std::isnan(f)) return 0x7fc00000; // All NaNs alike
+        if (f == 0) f = 0; // -0 as +0
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    //static
+    uint64_t ValueHash::hashDouble(double d) {
+        if (std::isnan(d)) return 0x7ff8000000000000ULL; // All NaNs alike
+        if (d == 0) d = 0; // -0 as +0
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+
+    //static
+    // Order matters: combine(combine(h, a), b) differs from combine(combine(h, b), a)
+    uint64_t ValueHash::combine(uint64_t h, uint64_t v) {
+        return mix(h ^ mix(v + 0x9e3779b97f4a7c15ULL));
+    }
+
+    //static
+    // The splitmix64 finalizer
+    uint64_t ValueHash::mix(uint64_t h) {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+} // namespace qpidit
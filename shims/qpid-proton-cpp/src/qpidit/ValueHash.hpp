@@ -0,0 +1,63 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_VALUEHASH_HPP_
+#define SRC_QPIDIT_VALUEHASH_HPP_
+
+#include <proton/codec.h>
+#include <stdint.h>
+#include <string>
+
+namespace proton {
+    class value;
+}
+
+namespace qpidit
+{
+
+    /*
+     * A 64-bit structural hash of a proton::value, found by walking its proton-c data in place. Every node
+     * is hashed with its AMQP type, so equal bytes of different types hash differently, and map entries are
+     * combined independently of their order. Values which ValueComparator finds equal hash the same: this
+     * includes 0.0 and -0.0, and any two NaNs. The hash is the same on every platform, so hashes from
+     * different shims or runs may be compared, or used as a key for a value.
+     */
+    class ValueHash
+    {
+    public:
+        // 0 for an empty value
+        static uint64_t hash(const proton::value& v);
+        // As 16 hex digits
+        static std::string hashString(const proton::value& v);
+    protected:
+        static uint64_t hashNode(pn_data_t* data);
+        static uint64_t hashChildren(pn_data_t* data, uint64_t h, std::size_t count);
+        static uint64_t hashMapEntries(pn_data_t* data, uint64_t h, std::size_t count);
+        static uint64_t hashBytes(uint64_t h, const char* bytes, std::size_t size);
+        static uint64_t hashFloat(float f);
+        static uint64_t hashDouble(double d);
+        static uint64_t combine(uint64_t h, uint64_t v);
+        static uint64_t mix(uint64_t h);
+    };
+
+} // namespace qpidit
+
+#endif /* SRC_QPIDIT_VALUEHASH_HPP_ */
@@ -19,9 +19,12 @@
  *
  */
 
+#include <algorithm>
 #include <sstream>
 
 #include <qpidit/amqp_complex_types_test/Common.hpp>
+#include <qpidit/amqp_complex_types_test/RandomValueGenerator.hpp>
+#include <qpidit/PnData.hpp>
 #include <qpidit/QpidItErrors.hpp>
 
 namespace qpidit
@@ -29,31 +32,21 @@ namespace qpidit
     namespace amqp_complex_types_test
     {
 
-        Common::Common(const std::string& amqpType, const std::string& amqpSubType) :
+        Common::Common(const std::string& amqpType, const std::string& amqpSubType, const qpidit::ShimOptions& options) :
                 _amqpType(amqpType),
-                _amqpSubType(amqpSubType)
+                _amqpSubType(amqpSubType),
+                _testData()
         {
-            initializeDataMap();
-            try {
-                const TestDataList_t& amqpTypeList = _testDataMap.at(_amqpType);
-                for (TestDataListCitr_t i = amqpTypeList.cbegin(); i != amqpTypeList.cend(); ++i) {
-                    if (isAmqpSubType(*i)) {
-                        _testData = *i;
-                        return;
-                    }
-                }
-                throw UnsupportedAmqpSubTypeError(_amqpSubType);
-            } catch (const std::out_of_range&) {
-                throw UnsupportedAmqpTypeError(_amqpType);
+            if (options.hasOption("random")) {
+                RandomValueGenerator(amqpType, amqpSubType, options.getString("random", "")).generate(_testData);
+            } else {
+                const TestDataEntry_t& testDataEntry = findTestDataEntry(amqpType, amqpSubType);
+                PnData::decode(_testData, testDataEntry.encoded, testDataEntry.encodedSize);
             }
         }
 
         Common::~Common() {}
 
-        bool Common::empty() const {
-            return _testDataMap.empty();
-        }
-
         //static
         void Common::setUuid(proton::uuid& val, const std::string& uuidStr) {
             // Expected format: "00000000-0000-0000-0000-000000000000"
@@ -66,59 +59,31 @@ namespace qpidit
             hexStringToBytearray(val, uuidStr.substr(24, 12), 10, 6);
         }
 
-        std::size_t Common::size() const {
-            return _testDataMap.size();
-        }
-
-        bool Common::isAmqpSubType(const proton::value& protonValue) const {
-            TestDataList_t valueList;
-            proton::get(protonValue, valueList);
+        // protected
 
-            // Special case: empty array/list/map
-            if (valueList.empty()) {
-                if (_amqpSubType.compare("None") == 0) return true;
-                return false;
-            }
+        // Copies the test value, which is not rebuilt for each message
+        void Common::getTestData(proton::value& v) const {
+            v = _testData;
+        }
 
-            // Special case: multi-typed list containing "*" as first entry or map containing "*":"*"
-            if (_amqpSubType.compare("*") == 0) {
-                proton::value thisValue = valueList[0];
-                if (thisValue.type() == proton::STRING) {
-                    std::string valStr;
-                    proton::get(thisValue, valStr);
-                    return valStr.compare("*") == 0;
-                }
-                return false;
+        //static
+        // Binary search of the generated table. The sub-type is that of the first element (for maps, the first
+        // value), "None" for an empty array/list/map, or "*" for a multi-typed list or map starting with "*".
+        const Common::TestDataEntry_t& Common::findTestDataEntry(const std::string& amqpType, const std::string& amqpSubType) {
+            const TestDataEntry_t* const end = s_testData + s_testDataSize;
+            const TestDataEntry_t* entry = std::partition_point(s_testData, end, [&](const TestDataEntry_t& e) {
+                const int typeOrder = amqpType.compare(e.amqpType);
+                return typeOrder > 0 || (typeOrder == 0 && amqpSubType.compare(e.amqpSubType) > 0);
+            });
+            const bool typeFound = (entry != end && amqpType.compare(entry->amqpType) == 0) ||
+                                   (entry != s_testData && amqpType.compare((entry - 1)->amqpType) == 0);
+            if (!typeFound) {
+                throw UnsupportedAmqpTypeError(amqpType);
             }
-
-            // For maps, examine the value (second list element) rather than the key (first list element)
-            switch (valueList[_amqpType.compare("map") == 0 ? 1 : 0].type()) {
-            case proton::NULL_TYPE: return _amqpSubType.compare("null") == 0;
-            case proton::BOOLEAN: return _amqpSubType.compare("boolean") == 0;
-            case proton::UBYTE: return _amqpSubType.compare("ubyte") == 0;
-            case proton::BYTE: return _amqpSubType.compare("byte") == 0;
-            case proton::USHORT: return _amqpSubType.compare("ushort") == 0;
-            case proton::SHORT: return _amqpSubType.compare("short") == 0;
-            case proton::UINT: return _amqpSubType.compare("uint") == 0;
-            case proton::INT: return _amqpSubType.compare("int") == 0;
-            case proton::ULONG: return _amqpSubType.compare("ulong") == 0;
-            case proton::LONG: return _amqpSubType.compare("long") == 0;
-            case proton::FLOAT: return _amqpSubType.compare("float") == 0;
-            case proton::DOUBLE: return _amqpSubType.compare("double") == 0;
-            case proton::DECIMAL32: return _amqpSubType.compare("decimal32") == 0;
-            case proton::DECIMAL64: return _amqpSubType.compare("decimal64") == 0;
-            case proton::DECIMAL128: return _amqpSubType.compare("decimal128") == 0;
-            case proton::CHAR: return _amqpSubType.compare("char") == 0;
-            case proton::TIMESTAMP: return _amqpSubType.compare("timestamp") == 0;
-            case proton::UUID: return _amqpSubType.compare("uuid") == 0;
-            case proton::BINARY: return _amqpSubType.compare("binary") == 0;
-            case proton::STRING: return _amqpSubType.compare("string") == 0;
-            case proton::SYMBOL: return _amqpSubType.compare("symbol") == 0;
-            case proton::ARRAY: return _amqpSubType.compare("array") == 0;
-            case proton::LIST: return _amqpSubType.compare("list") == 0;
-            case proton::MAP: return _amqpSubType.compare("map") == 0;
-            default: return false;
+            if (entry == end || amqpType.compare(entry->amqpType) != 0 || amqpSubType.compare(entry->amqpSubType) != 0) {
+                throw UnsupportedAmqpSubTypeError(amqpSubType);
             }
+            return *entry;
         }
 
     } /* namespace amqp_complex_types_test */
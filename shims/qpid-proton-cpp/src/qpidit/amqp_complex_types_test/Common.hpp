@@ -22,10 +22,10 @@
 #ifndef SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_COMMON_HPP_
 #define SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_COMMON_HPP_
 
-#include <map>
 #include <vector>
 
 #include <proton/types.hpp>
+#include <qpidit/ShimOptions.hpp>
 
 namespace qpidit
 {
@@ -34,23 +34,29 @@ namespace qpidit
 
         typedef std::vector<proton::value> TestDataList_t;
         typedef TestDataList_t::const_iterator TestDataListCitr_t;
-        typedef std::map<const std::string, const TestDataList_t> TestDataMap_t;
 
         class Common {
           protected:
+            // One test value in AMQP wire format. The generated data file holds these as constant bytes, so no
+            // test value is built until a shim decodes the one it uses.
+            struct TestDataEntry_t {
+                const char* amqpType;
+                const char* amqpSubType;
+                const char* encoded;
+                std::size_t encodedSize;
+            };
+            static const TestDataEntry_t s_testData[]; // Generated, sorted by amqpType then amqpSubType
+            static const std::size_t s_testDataSize; // Generated
+
             const std::string _amqpType;
             const std::string _amqpSubType;
-            TestDataMap_t _testDataMap;
-            proton::value _testData;
+            proton::value _testData; // Built once, from the generated test data or from the --random seed
           public:
-            Common(const std::string& amqpType, const std::string& amqpSubType);
+            Common(const std::string& amqpType, const std::string& amqpSubType, const qpidit::ShimOptions& options);
             virtual ~Common();
 
-            bool empty() const;
             static std::string hexStringToBinaryString(const std::string& s);
-            void initializeDataMap(); // Generated function
             static void setUuid(proton::uuid& val, const std::string& uuidStr);
-            std::size_t size() const;
 
             template<size_t N> static void hexStringToBytearray(proton::byte_array<N>& ba, const std::string& s, size_t fromArrayIndex = 0, size_t arrayLen = N) {
                 size_t len = (s.size()/2 > arrayLen) ? arrayLen : s.size()/2;
@@ -60,7 +66,8 @@ namespace qpidit
             }
 
           protected:
-            bool isAmqpSubType(const proton::value& val) const;
+            void getTestData(proton::value& v) const;
+            static const TestDataEntry_t& findTestDataEntry(const std::string& amqpType, const std::string& amqpSubType);
         };
 
 
@@ -0,0 +1,240 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <qpidit/amqp_complex_types_test/RandomValueGenerator.hpp>
+
+#include <cstdlib>
+#include <sstream>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/QpidItErrors.hpp>
+
+namespace qpidit
+{
+    namespace amqp_complex_types_test
+    {
+
+        // NULL_TYPE first, as arrays of null are not generated
+        const proton::type_id RandomValueGenerator::s_primitiveTypes[] = {
+            proton::NULL_TYPE, proton::BOOLEAN, proton::UBYTE, proton::USHORT, proton::UINT, proton::ULONG,
+            proton::BYTE, proton::SHORT, proton::INT, proton::LONG, proton::FLOAT, proton::DOUBLE,
+            proton::DECIMAL32, proton::DECIMAL64, proton::DECIMAL128, proton::CHAR, proton::TIMESTAMP,
+            proton::UUID, proton::BINARY, proton::STRING, proton::SYMBOL
+        };
+        const std::size_t RandomValueGenerator::s_numPrimitiveTypes = sizeof(s_primitiveTypes) / sizeof(s_primitiveTypes[0]);
+        const proton::type_id RandomValueGenerator::s_keyTypes[] = { proton::ULONG, proton::STRING, proton::SYMBOL };
+        const std::size_t RandomValueGenerator::s_numKeyTypes = sizeof(s_keyTypes) / sizeof(s_keyTypes[0]);
+
+        RandomValueGenerator::RandomValueGenerator(const std::string& amqpType,
+                                                   const std::string& amqpSubType,
+                                                   const std::string& spec) :
+                        _amqpType(containerTypeId(amqpType)),
+                        _anySubType(amqpSubType.compare("*") == 0),
+                        _amqpSubType(_anySubType ? proton::NULL_TYPE : primitiveTypeId(amqpSubType)),
+                        _depth(3),
+                        _width(4),
+                        _seed(0)
+        {
+            parseSpec(spec);
+            if (_amqpType == proton::ARRAY && !arraysAllowed()) {
+                throw UnsupportedAmqpSubTypeError(amqpSubType);
+            }
+        }
+
+        RandomValueGenerator::~RandomValueGenerator() {}
+
+        // Each call starts from the seed, so the sender and receiver build the same value
+        void RandomValueGenerator::generate(proton::value& v) const {
+            Engine_t engine(_seed);
+            v.clear();
+            proton::codec::encoder encoder(v);
+            putContainer(encoder, engine, _amqpType, _depth);
+        }
+
+        // protected
+
+        // Parameters are depth, width and seed, in any order, each defaulting if left out
+        void RandomValueGenerator::parseSpec(const std::string& spec) {
+            std::istringstream iss(spec);
+            std::string param;
+            while (std::getline(iss, param, ',')) {
+                const std::size_t eqPos = param.find('=');
+                const std::string name(param.substr(0, eqPos));
+                const char* valueStr = eqPos == std::string::npos ? "" : param.c_str() + eqPos + 1;
+                char* end = 0;
+                const uint64_t value = std::strtoull(valueStr, &end, 0);
+                if (*valueStr == '\0' || *end != '\0') {
+                    throw ArgumentError(MSG("--random: expected name=number, found \"" << param << "\""));
+                }
+                if (name.compare("depth") == 0) {
+                    _depth = value;
+                } else if (name.compare("width") == 0) {
+                    _width = value;
+                } else if (name.compare("seed") == 0) {
+                    _seed = value;
+                } else {
+                    throw ArgumentError(MSG("--random: unknown parameter \"" << name << "\", expected depth, width or seed"));
+                }
+            }
+            if (_depth == 0) {
+                throw ArgumentError("--random: depth must be at least 1");
+            }
+        }
+
+        bool RandomValueGenerator::arraysAllowed() const {
+            return _anySubType || _amqpSubType != proton::NULL_TYPE;
+        }
+
+        // depth counts this container
+        void RandomValueGenerator::putContainer(proton::codec::encoder& e, Engine_t& engine, proton::type_id type, uint64_t depth) const {
+            switch (type) {
+            case proton::LIST:
+                e << proton::codec::start::list();
+                for (uint64_t i=0; i<_width; ++i) {
+                    putElement(e, engine, depth - 1);
+                }
+                break;
+            case proton::MAP: {
+                const proton::type_id keyType = s_keyTypes[below(engine, s_numKeyTypes)];
+                e << proton::codec::start::map();
+                for (uint64_t i=0; i<_width; ++i) {
+                    putKey(e, engine, keyType, i);
+                    putElement(e, engine, depth - 1);
+                }
+                break;
+            }
+            default: { // proton::ARRAY
+                const proton::type_id elementType = primitiveType(engine, true);
+                e << proton::codec::start::array(elementType);
+                for (uint64_t i=0; i<_width; ++i) {
+                    putPrimitive(e, engine, elementType);
+                }
+            }
+            }
+            e << proton::codec::finish();
+        }
+
+        // depth counts the containers which may still nest here: with none left, the element is primitive
+        void RandomValueGenerator::putElement(proton::codec::encoder& e, Engine_t& engine, uint64_t depth) const {
+            switch (depth == 0 ? 0 : below(engine, arraysAllowed() ? 4 : 3)) {
+            case 0: putPrimitive(e, engine, primitiveType(engine, false)); break;
+            case 1: putContainer(e, engine, proton::LIST, depth); break;
+            case 2: putContainer(e, engine, proton::MAP, depth); break;
+            default: putContainer(e, engine, proton::ARRAY, depth);
+            }
+        }
+
+        proton::type_id RandomValueGenerator::primitiveType(Engine_t& engine, bool arrayElement) const {
+            if (!_anySubType) return _amqpSubType;
+            return arrayElement ? s_primitiveTypes[1 + below(engine, s_numPrimitiveTypes - 1)]
+                                : s_primitiveTypes[below(engine, s_numPrimitiveTypes)];
+        }
+
+        //static
+        proton::type_id RandomValueGenerator::containerTypeId(const std::string& amqpType) {
+            proton::type_id typeId = proton::NULL_TYPE;
+            if (!AmqpTypes::findTypeId(amqpType, typeId) ||
+                (typeId != proton::LIST && typeId != proton::MAP && typeId != proton::ARRAY)) {
+                throw UnsupportedAmqpTypeError(amqpType);
+            }
+            return typeId;
+        }
+
+        //static
+        proton::type_id RandomValueGenerator::primitiveTypeId(const std::string& amqpSubType) {
+            proton::type_id typeId = proton::NULL_TYPE;
+            if (!AmqpTypes::findTypeId(amqpSubType, typeId) ||
+                typeId == proton::LIST || typeId == proton::MAP || typeId == proton::ARRAY) {
+                throw UnsupportedAmqpSubTypeError(amqpSubType);
+            }
+            return typeId;
+        }
+
+        //static
+        void RandomValueGenerator::putPrimitive(proton::codec::encoder& e, Engine_t& engine, proton::type_id type) {
+            switch (type) {
+            case proton::NULL_TYPE: e << nullptr; break;
+            case proton::BOOLEAN: e << bool(engine() & 1); break;
+            case proton::UBYTE: e << static_cast<uint8_t>(engine()); break;
+            case proton::USHORT: e << static_cast<uint16_t>(engine()); break;
+            case proton::UINT: e << static_cast<uint32_t>(engine()); break;
+            case proton::ULONG: e << static_cast<uint64_t>(engine()); break;
+            case proton::BYTE: e << static_cast<int8_t>(engine()); break;
+            case proton::SHORT: e << static_cast<int16_t>(engine()); break;
+            case proton::INT: e << static_cast<int32_t>(engine()); break;
+            case proton::LONG: e << static_cast<int64_t>(engine()); break;
+            // Scaled integers reach both signs and fractions, and are never NaN or infinite
+            case proton::FLOAT: e << float(static_cast<int32_t>(engine())) / 1024; break;
+            case proton::DOUBLE: e << double(static_cast<int64_t>(engine())) / 1048576; break;
+            case proton::DECIMAL32: { proton::decimal32 d; randomBytes(engine, d); e << d; break; }
+            case proton::DECIMAL64: { proton::decimal64 d; randomBytes(engine, d); e << d; break; }
+            case proton::DECIMAL128: { proton::decimal128 d; randomBytes(engine, d); e << d; break; }
+            case proton::UUID: { proton::uuid u; randomBytes(engine, u); e << u; break; }
+            case proton::CHAR: e << static_cast<wchar_t>(below(engine, 0xd800)); break; // Code points below the surrogates
+            case proton::TIMESTAMP: e << proton::timestamp(static_cast<int64_t>(engine())); break;
+            case proton::BINARY: {
+                proton::binary b;
+                for (uint64_t size = below(engine, s_maxBytesSize + 1); size > 0; --size) {
+                    b.push_back(static_cast<uint8_t>(engine()));
+                }
+                e << b;
+                break;
+            }
+            case proton::STRING: e << randomAscii(engine); break;
+            case proton::SYMBOL: e << proton::symbol(randomAscii(engine)); break;
+            default: throw UnsupportedAmqpSubTypeError(AmqpTypes::typeName(type));
+            }
+        }
+
+        //static
+        // The index in the low half keeps keys unique within their map
+        void RandomValueGenerator::putKey(proton::codec::encoder& e, Engine_t& engine, proton::type_id type, uint64_t index) {
+            const uint64_t key = (engine() << 32) | (index & 0xffffffff);
+            if (type == proton::ULONG) {
+                e << key;
+                return;
+            }
+            std::ostringstream oss;
+            oss << std::hex << key;
+            if (type == proton::SYMBOL) {
+                e << proton::symbol(oss.str());
+            } else {
+                e << oss.str();
+            }
+        }
+
+        //static
+        // Plain modulo: its bias is negligible for the small ranges used, and it is the same everywhere
+        uint64_t RandomValueGenerator::below(Engine_t& engine, uint64_t n) {
+            return engine() % n;
+        }
+
+        //static
+        // Printable ASCII, valid as both a string and a symbol
+        std::string RandomValueGenerator::randomAscii(Engine_t& engine) {
+            std::string s(below(engine, s_maxBytesSize + 1), ' ');
+            for (std::string::iterator i = s.begin(); i != s.end(); ++i) {
+                *i = static_cast<char>(' ' + below(engine, '~' - ' ' + 1));
+            }
+            return s;
+        }
+
+    } /* namespace amqp_complex_types_test */
+} /* namespace qpidit */
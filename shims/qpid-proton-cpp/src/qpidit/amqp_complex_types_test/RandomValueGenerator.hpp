@@ -0,0 +1,94 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_RANDOMVALUEGENERATOR_HPP_
+#define SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_RANDOMVALUEGENERATOR_HPP_
+
+#include <proton/codec/encoder.hpp>
+#include <proton/types.hpp>
+#include <random>
+#include <stdint.h>
+#include <string>
+
+namespace qpidit
+{
+    namespace amqp_complex_types_test
+    {
+
+        /*
+         * Builds the test value for --random depth=D,width=W,seed=S in place of one from the generated test data.
+         * The value depends only on the AMQP type, sub-type and spec, so a receiver checks what it receives by
+         * building the value again.
+         *
+         * The value is an amqpType (list, map or array) of W elements. Each list or map element is either a
+         * primitive value, or a list, map or array of W elements of its own, down to D levels of containers.
+         * Arrays hold primitive values only. Primitive values are of the sub-type, or of every primitive type
+         * at random for sub-type "*". Map keys are ulongs, strings or symbols, unique within their map.
+         */
+        class RandomValueGenerator
+        {
+        protected:
+            // Only the raw engine output is used: the standard fixes mt19937_64's sequence, but not those of the
+            // distributions, which would let two standard libraries build different values from one seed
+            typedef std::mt19937_64 Engine_t;
+
+            static const proton::type_id s_primitiveTypes[];
+            static const std::size_t s_numPrimitiveTypes;
+            static const proton::type_id s_keyTypes[];
+            static const std::size_t s_numKeyTypes;
+            static const std::size_t s_maxBytesSize = 32; // Longest binary, string or symbol value
+
+            const proton::type_id _amqpType;
+            const bool _anySubType; // "*"
+            const proton::type_id _amqpSubType; // Unused when _anySubType
+            uint64_t _depth;
+            uint64_t _width;
+            uint64_t _seed;
+        public:
+            RandomValueGenerator(const std::string& amqpType, const std::string& amqpSubType, const std::string& spec);
+            virtual ~RandomValueGenerator();
+
+            void generate(proton::value& v) const;
+        protected:
+            void parseSpec(const std::string& spec);
+            bool arraysAllowed() const;
+            void putContainer(proton::codec::encoder& e, Engine_t& engine, proton::type_id type, uint64_t depth) const;
+            void putElement(proton::codec::encoder& e, Engine_t& engine, uint64_t depth) const;
+            proton::type_id primitiveType(Engine_t& engine, bool arrayElement) const;
+
+            static proton::type_id containerTypeId(const std::string& amqpType);
+            static proton::type_id primitiveTypeId(const std::string& amqpSubType);
+            static void putPrimitive(proton::codec::encoder& e, Engine_t& engine, proton::type_id type);
+            static void putKey(proton::codec::encoder& e, Engine_t& engine, proton::type_id type, uint64_t index);
+            static uint64_t below(Engine_t& engine, uint64_t n);
+            static std::string randomAscii(Engine_t& engine);
+
+            template<std::size_t N> static void randomBytes(Engine_t& engine, proton::byte_array<N>& ba) {
+                for (std::size_t i=0; i<N; ++i) {
+                    ba[i] = static_cast<uint8_t>(engine());
+                }
+            }
+        };
+
+    } /* namespace amqp_complex_types_test */
+} /* namespace qpidit */
+
+#endif /* SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_RANDOMVALUEGENERATOR_HPP_ */
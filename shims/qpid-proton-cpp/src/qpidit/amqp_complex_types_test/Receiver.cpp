@@ -26,112 +26,62 @@
 #include <proton/container.hpp>
 #include <proton/delivery.hpp>
 #include <proton/message.hpp>
+#include <qpidit/PnData.hpp>
 #include <qpidit/QpidItErrors.hpp>
+#include <qpidit/ValueComparator.hpp>
+#include <qpidit/ValueHash.hpp>
 
 namespace qpidit
 {
     namespace amqp_complex_types_test
     {
 
+        const std::size_t Receiver::s_maxPrintedValueSize = 4096;
+
         Receiver::Receiver(const std::string& brokerAddr,
                            const std::string& queueName,
                            const std::string& amqpType,
-                           const std::string& amqpSubType) :
-                           AmqpReceiverBase("amqp_complex_types_test::Receiver", brokerAddr, queueName),
-                           Common(amqpType, amqpSubType)
-        {}
+                           const std::string& amqpSubType,
+                           const qpidit::ShimOptions& options) :
+                           AmqpReceiverBase("amqp_complex_types_test::Receiver", brokerAddr, queueName, options),
+                           Common(amqpType, amqpSubType, options)
+        {
+            if (getNumLinks() > 1 || getNumThreads() > 1) {
+                throw qpidit::ArgumentError("amqp_complex_types_test only supports a single link on a single thread");
+            }
+        }
 
         Receiver::~Receiver() {}
 
         void Receiver::on_message(proton::delivery &d, proton::message &m) {
             try {
-                checkEqual(m.body(), _testData);
+                // Walks both values in place, so a matching body is checked without copying any of it out
+                ValueComparator comparator;
+                if (comparator.equal(m.body(), _testData)) {
+                    _result << "pass";
+                } else {
+                    reportFailure(m.body(), comparator.failure());
+                }
+                messageProcessed(d);
             } catch (const std::exception&) {
-                d.receiver().close();
-                d.connection().close();
+                closeConnections();
                 throw;
             }
-            d.receiver().close();
-            d.connection().close();
+            closeConnections();
         }
 
         std::string Receiver::result() const { return _result.str(); }
 
         // protected
 
-        void Receiver::checkEqual(proton::value received, proton::value expected) {
-            if (_amqpType.compare("map") == 0) {
-                checkMapEqual(received, expected);
-            } else {
-                checkListEqual(received, expected);
-            }
-            if (_result.tellp() == 0) { // no errors
-                _result << "pass";
-            }
-        }
-
-        void Receiver::checkListEqual(proton::value received, proton::value expected) {
-            TestDataList_t receivedList;
-            proton::get(received, receivedList);
-            TestDataList_t expectedList;
-            proton::get(expected, expectedList);
-
-            // Check list sizes equal
-            if (receivedList.size() != expectedList.size()) {
-                _result << "FAIL: unequal list length: received length=" << receivedList.size();
-                _result << ", expected length=" << expectedList.size() << "\n  received: " << received << "\n  expected: " << expected;
-                return;
-            }
-
-            // Special case: empty lists
-            if (receivedList.empty() && expectedList.empty()) {
-                return;
-            }
-
-            TestDataListCitr_t r, e;
-            for (r = receivedList.cbegin(), e = expectedList.cbegin(); r != receivedList.cend() && e != expectedList.cend(); ++r, ++e) {
-                if (e->type() == proton::MAP) {
-                    checkMapEqual(*r, *e);
-                } else if (e->type() == proton::LIST) {
-                    checkListEqual(*r, *e);
-                } else if (*r != *e) {
-                    _result << "FAIL: " << (*r) << " != " << (*e) << "\n  received: " << received << "\n  expected: " << expected;
-                    return;
-                }
-            }
-        }
-
-        void Receiver::checkMapEqual(proton::value received, proton::value expected) {
-            std::map<proton::value, proton::value> receivedMap;
-            proton::get(received, receivedMap);
-            std::map<proton::value, proton::value> expectedMap;
-            proton::get(expected, expectedMap);
-            if (receivedMap.size() != expectedMap.size()) {
-                _result << "FAIL: unequal map size: received size=" << receivedMap.size();
-                _result << ", expected size=" << expectedMap.size() << "\n  received: " << received << "\n  expected: " << expected;
-                return;
-            }
-
-            // Special case: empty maps
-            if (receivedMap.empty() && expectedMap.empty()) {
-                return;
-            }
-
-            // Must iterate through map keys as map ordering is not guaranteed
-            for (std::map<proton::value, proton::value>::const_iterator i = receivedMap.cbegin(); i != receivedMap.cend(); ++i) {
-                if (i->second.type() == proton::LIST) {
-                    checkListEqual(i->second, expectedMap.at(i->first));
-                } else {
-                    try {
-                        if (expectedMap.at(i->first) != i->second) {
-                            _result << "FAIL: Value for map key \"" << i->first << "\" differs:\n  received: " << received << "\n  expected: " << expected;
-                            return;
-                        }
-                    } catch (const std::out_of_range& e) {
-                        _result << "FAIL: Map key \"" << i->first << "\" not found in expected:\n  received: " << received << "\n  expected: " << expected;
-                        return;
-                    }
-                }
+        // The failure gives the path to the first difference, so the whole values are only printed while they are
+        // small enough to read: a large (eg --random) value is identified by its hash instead
+        void Receiver::reportFailure(const proton::value& received, const std::string& failure) {
+            _result << "FAIL: " << failure
+                    << "\n  received hash: " << ValueHash::hashString(received)
+                    << "\n  expected hash: " << ValueHash::hashString(_testData);
+            if (PnData::encodedSize(received) <= s_maxPrintedValueSize && PnData::encodedSize(_testData) <= s_maxPrintedValueSize) {
+                _result << "\n  received: " << received << "\n  expected: " << _testData;
             }
         }
 
@@ -145,16 +95,24 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: AMQP subtype
+ *       5+: Options (optional):
+ *           --random depth=D,width=W,seed=S: Expect the random nested value which the sender builds with the
+ *                                            same options
+ *           --credit-window N: Issue N credits on the link (default: the proton default window)
+ *           --credit-low-water M: Manage credit manually, topping it back up to N once it falls to M
+ *           --ack-batch B: Accept deliveries B at a time (default 1)
  */
 
 int main(int argc, char** argv) {
     // TODO: improve arg management a little...
-    if (argc != 5) {
+    if (argc < 5) {
         throw qpidit::ArgumentError("Incorrect number of arguments");
     }
 
     try {
-        qpidit::amqp_complex_types_test::Receiver receiver(argv[1], argv[2], argv[3], argv[4]);
+        const qpidit::ShimOptions options(argc, argv, 5);
+        qpidit::amqp_complex_types_test::Receiver receiver(argv[1], argv[2], argv[3], argv[4], options);
+        options.checkAllUsed();
         proton::container(receiver).run();
 
         std::cout << argv[3] << "\n";
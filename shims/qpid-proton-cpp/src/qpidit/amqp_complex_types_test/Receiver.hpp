@@ -23,6 +23,7 @@
 #define SRC_QPIDIT_AMQP_COMPLEX_TYPES_TEST_RECEIVER_HPP_
 
 #include <sstream>
+#include <proton/value.hpp>
 #include <qpidit/AmqpReceiverBase.hpp>
 #include <qpidit/amqp_complex_types_test/Common.hpp>
 
@@ -34,17 +35,21 @@ namespace qpidit
         class Receiver : public qpidit::AmqpReceiverBase, Common
         {
         protected:
+            static const std::size_t s_maxPrintedValueSize;
+
             std::ostringstream _result;
         public:
-            Receiver(const std::string& brokerAddr, const std::string& queueName, const std::string& amqpType, const std::string& amqpSubType);
+            Receiver(const std::string& brokerAddr,
+                     const std::string& queueName,
+                     const std::string& amqpType,
+                     const std::string& amqpSubType,
+                     const qpidit::ShimOptions& options);
             virtual ~Receiver();
 
             void on_message(proton::delivery &d, proton::message &m);
             std::string result() const;
         protected:
-            void checkEqual(proton::value received, proton::value expected);
-            void checkListEqual(proton::value received, proton::value expected);
-            void checkMapEqual(proton::value received, proton::value expected);
+            void reportFailure(const proton::value& received, const std::string& failure);
         };
 
     } /* namespace amqp_complex_types_test */
@@ -35,25 +35,29 @@ namespace qpidit
         Sender::Sender(const std::string& brokerAddr,
                        const std::string& queueName,
                        const std::string& amqpType,
-                       const std::string& amqpSubType) :
-                       AmqpSenderBase("amqp_complex_types_test::Sender", brokerAddr, queueName, 1),
-                       Common(amqpType, amqpSubType)
-        {}
+                       const std::string& amqpSubType,
+                       const qpidit::ShimOptions& options) :
+                       AmqpSenderBase("amqp_complex_types_test::Sender", brokerAddr, queueName, 1, options),
+                       Common(amqpType, amqpSubType, options)
+        {
+            if (_latencyFlag) {
+                // The receiver compares the body only, it does not record latency
+                throw qpidit::ArgumentError("--latency is not supported by amqp_complex_types_test");
+            }
+        }
 
         Sender::~Sender() {}
 
-        void Sender::on_sendable(proton::sender &s) {
-            if (_totalMsgs == 0) {
-                s.connection().close();
-            } else if (_msgsSent == 0) {
-                proton::message msg;
-                msg.id(_msgsSent + 1);
-                msg.body(_testData);
-                s.send(msg);
-                _msgsSent++;
-            } else {
-                // do nothing
-            }
+        // protected
+
+        proton::message& Sender::setMessage(proton::message& msg, uint32_t msgNum) {
+            msg.id(msgNum + 1);
+            getTestData(msg.body());
+            return msg;
+        }
+
+        uint32_t Sender::getContentKey(uint32_t msgNum) const {
+            return 0;
         }
 
 
@@ -67,17 +71,27 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: AMQP subytpe
+ *       5+: Options (optional):
+ *           --pre-encoded: Encode the test data once, then send the encoded bytes with a patched message-id
+ *           --delivery-mode at-least-once|at-most-once: at-most-once sends pre-settled messages (default at-least-once)
+ *           --connections C: Open C connections (default 1)
+ *           --links-per-connection L: Open L sender links on each connection (default 1)
+ *           --threads T: Run the container with T threads (default 1)
+ *           --random depth=D,width=W,seed=S: Send a random nested value built from seed S in place of the test data
+ *                                            (default depth 3, width 4, seed 0); the sub-type may be "*"
  */
 
 int main(int argc, char** argv) {
     try {
         // TODO: improve arg management a little...
-        if (argc != 5) {
+        if (argc < 5) {
             throw qpidit::ArgumentError("Incorrect number of arguments");
         }
+        const qpidit::ShimOptions options(argc, argv, 5);
 
-        qpidit::amqp_complex_types_test::Sender sender(argv[1], argv[2], argv[3], argv[4]);
-        proton::container(sender).run();
+        qpidit::amqp_complex_types_test::Sender sender(argv[1], argv[2], argv[3], argv[4], options);
+        options.checkAllUsed();
+        proton::container(sender).run(sender.getNumThreads());
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         std::exit(1);
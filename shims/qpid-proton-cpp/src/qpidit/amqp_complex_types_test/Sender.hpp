@@ -33,10 +33,16 @@ namespace qpidit
         class Sender : public qpidit::AmqpSenderBase, Common
         {
         public:
-            Sender(const std::string& brokerAddr, const std::string& queueName, const std::string& amqpType, const std::string& amqpSubType);
+            Sender(const std::string& brokerAddr,
+                   const std::string& queueName,
+                   const std::string& amqpType,
+                   const std::string& amqpSubType,
+                   const qpidit::ShimOptions& options);
             virtual ~Sender();
 
-            void on_sendable(proton::sender &s);
+        protected:
+            proton::message& setMessage(proton::message& msg, uint32_t msgNum);
+            uint32_t getContentKey(uint32_t msgNum) const;
         };
 
     } /* namespace amqp_complex_types_test */
@@ -21,6 +21,7 @@
 
 #include "qpidit/amqp_large_content_test/Receiver.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <json/json.h>
 #include <stdlib.h> // exit()
@@ -29,125 +30,308 @@
 #include <proton/delivery.hpp>
 #include <proton/message.hpp>
 #include <proton/receiver.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/Crc32c.hpp>
+#include <qpidit/PnData.hpp>
 #include <qpidit/QpidItErrors.hpp>
+#include <qpidit/TestPattern.hpp>
 
 namespace qpidit
 {
     namespace amqp_large_content_test
     {
 
+        // Small enough that a chunk is still in cache when the CRC reads it after the pattern check
+        const size_t Receiver::s_verifyChunkSize = 128 * 1024;
+
         Receiver::Receiver(const std::string& brokerAddr,
                            const std::string& queueName,
                            const std::string& amqpType,
-                           uint32_t expected) :
-                        AmqpReceiverBase("amqp_large_content_test::Receiver", brokerAddr, queueName),
+                           uint32_t expected,
+                           const qpidit::ShimOptions& options) :
+                        AmqpReceiverBase("amqp_large_content_test::Receiver", brokerAddr, queueName, options),
                         _amqpType(amqpType),
-                        _expected(expected),
+                        _amqpTypeId(AmqpTypes::typeId(amqpType)),
+                        _expected(options.getUInt("repeat", 1) * expected),
                         _received(0UL),
-                        _receivedValueList(Json::arrayValue)
-        {}
+                        _bodySizeCounts(),
+                        _bodySizeIndex(),
+                        _sizeBytesFlag(options.getFlag("size-bytes")),
+                        _benchmarkFlag(options.hasOption("repeat")),
+                        _perfStats(),
+                        _decodeCostFlag(options.getFlag("decode-cost")),
+                        _encodedMessage(),
+                        _decodedElements(0),
+                        _decodeNs(0),
+                        _walkNs(0),
+                        _ndjsonWriter(options.getFlag("stream") ? new NdjsonWriter(std::cout) : 0)
+        {
+            if (getNumLinks() > 1 || getNumThreads() > 1) {
+                // The received sizes and stats are kept for a single link, on a single thread
+                throw qpidit::ArgumentError("amqp_large_content_test only supports a single link on a single thread");
+            }
+        }
 
         Receiver::~Receiver() {}
 
-        Json::Value& Receiver::getReceivedValueList() {
-            return _receivedValueList;
+        // Built from the received body sizes once all have arrived. Binary, string and symbol give a list of sizes,
+        // list and map a list of [size, [num elements, ...]] grouped by size in the order each size first arrived.
+        // Repeats of the same body size are listed together, where it first arrived.
+        Json::Value Receiver::getReceivedValueList() const {
+            Json::Value receivedValueList(Json::arrayValue);
+            std::unordered_map<uint32_t, Json::ArrayIndex> sizeIndex; // List and map size -> index in receivedValueList
+            for (std::vector<std::pair<BodySize_t, uint32_t> >::const_iterator i=_bodySizeCounts.begin(); i!=_bodySizeCounts.end(); ++i) {
+                const BodySize_t& bodySize = i->first;
+                if (isListOrMap()) {
+                    const std::pair<std::unordered_map<uint32_t, Json::ArrayIndex>::iterator, bool> inserted =
+                                    sizeIndex.insert(std::make_pair(bodySize.first, receivedValueList.size()));
+                    if (inserted.second) {
+                        Json::Value sizeVal(Json::arrayValue);
+                        sizeVal.append(bodySize.first);
+                        sizeVal.append(Json::Value(Json::arrayValue));
+                        receivedValueList.append(sizeVal);
+                    }
+                    Json::Value& numEltsList = receivedValueList[inserted.first->second][1];
+                    for (uint32_t j=0; j<i->second; ++j) {
+                        numEltsList.append(bodySize.second);
+                    }
+                } else {
+                    for (uint32_t j=0; j<i->second; ++j) {
+                        receivedValueList.append(bodySize.first);
+                    }
+                }
+            }
+            return receivedValueList;
+        }
+
+        bool Receiver::isBenchmark() const {
+            return _benchmarkFlag;
+        }
+
+        Json::Value Receiver::getStats() const {
+            Json::Value stats(_perfStats.toJson());
+            if (AllocTracker::isEnabled()) {
+                stats["alloc"] = AllocTracker::toJson();
+            }
+            if (_decodeCostFlag) {
+                stats["decodeCost"] = getDecodeCost();
+            }
+            return stats;
+        }
+
+        // Mean time per element for proton to decode the bodies, and for inspectTestBody() to walk and verify them
+        Json::Value Receiver::getDecodeCost() const {
+            Json::Value decodeCost(Json::objectValue);
+            decodeCost["elements"] = Json::UInt64(_decodedElements);
+            decodeCost["decodeNsPerElement"] = _decodedElements > 0 ? double(_decodeNs) / _decodedElements : 0.0;
+            decodeCost["walkNsPerElement"] = _decodedElements > 0 ? double(_walkNs) / _decodedElements : 0.0;
+            return decodeCost;
+        }
+
+        bool Receiver::isStreaming() const {
+            return _ndjsonWriter.get() != 0;
+        }
+
+        // The summary carries the benchmark stats, if any, in place of a received value list
+        void Receiver::writeStreamSummary() {
+            Json::Value summary(Json::objectValue);
+            if (_benchmarkFlag) {
+                summary["stats"] = getStats();
+            } else if (_decodeCostFlag) {
+                summary["decodeCost"] = getDecodeCost();
+            }
+            _ndjsonWriter->writeSummary(summary);
         }
 
         void Receiver::on_message(proton::delivery &d, proton::message &m) {
             try {
                 if (_received < _expected) {
-                    if (_amqpType.compare("binary") == 0 || _amqpType.compare("string") == 0 || _amqpType.compare("symbol") == 0) {
-                        _receivedValueList.append(getTestStringSizeMb(m.body()));
+                    // Receive time runs from the first message arriving to the last
+                    if (_benchmarkFlag && !_perfStats.isStarted()) {
+                        _perfStats.start();
+                    }
+                    if (_decodeCostFlag) {
+                        timeDecode(m);
+                    }
+                    const int64_t walkStartNs = _decodeCostFlag ? PerfStats::monotonicNs() : 0;
+                    const std::pair<uint64_t, uint32_t> bodySize(inspectTestBody(m)); // bytes, number of elements
+                    if (_decodeCostFlag) {
+                        _walkNs += PerfStats::monotonicNs() - walkStartNs;
+                        _decodedElements += bodySize.second;
+                    }
+                    if (_benchmarkFlag) {
+                        _perfStats.add(1, bodySize.first);
                     } else {
-                        std::pair<uint32_t, uint32_t> ret;
-                        if (_amqpType.compare("list") == 0) {
-                            ret = getTestListSizeMb(m.body());
-                        } else {
-                            ret = getTestMapSizeMb(m.body());
-                        }
-                        if (_receivedValueList.empty()) {
-                            createNewListMapSize(ret);
-                        } else {
-                            bool found = false;
-                            for (Json::ValueIterator i = _receivedValueList.begin(); i != _receivedValueList.end(); ++i) {
-                                // JSON Array has exactly 2 elements: size and a JSON Array of number of elements found
-                                const uint32_t lastSize = (*i)[0].asInt(); // total size (sum of elements)
-                                if (ret.first == lastSize) {
-                                    found = true;
-                                    appendListMapSize((*i)[1], ret);
-                                    break;
-                                }
-                            }
-                            if (!found) {
-                                createNewListMapSize(ret);
-                            }
-                        }
+                        recordTestBody(bodySize);
                     }
                 }
                 _received++;
+                messageProcessed(d);
                 if (_received >= _expected) {
-                    d.receiver().close();
-                    d.connection().close();
+                    if (_benchmarkFlag && !_perfStats.isStopped()) {
+                        _perfStats.stop();
+                    }
+                    closeConnections();
                 }
             } catch (const std::exception&) {
-                d.receiver().close();
-                d.connection().close();
+                closeConnections();
                 throw;
             }
         }
 
         // protected
 
-        std::pair<uint32_t, uint32_t> Receiver::getTestListSizeMb(const proton::value& pvTestList) {
-            // Uniform elt size assumed
-            const std::vector<proton::value>& testList(proton::get<std::vector<proton::value> >(pvTestList));
-            if (testList.empty()) {
-                std::ostringstream oss;
-                oss << _testName << "::Receiver::getTestListSizeMb: List empty";
-                throw qpidit::ArgumentError(oss.str());
+        // Proton has already decoded m by the time on_message() sees it, so the decode is timed by decoding its
+        // encoding again. Wide lists and maps show the per-element node and allocation costs of proton's decoder.
+        void Receiver::timeDecode(const proton::message& m) {
+            m.encode(_encodedMessage);
+            proton::message decoded;
+            const int64_t startNs = PerfStats::monotonicNs();
+            decoded.decode(_encodedMessage);
+            _decodeNs += PerfStats::monotonicNs() - startNs;
+        }
+
+        // Adds the size (and number of elements for list and map) of a received test body to the received values,
+        // counted by body size so that each message costs one hash lookup
+        void Receiver::recordTestBody(const std::pair<uint64_t, uint32_t>& bodySize) {
+            const BodySize_t recordedSize(_sizeBytesFlag ? bodySize.first : bodySize.first / 1024 / 1024, bodySize.second);
+            if (_ndjsonWriter) {
+                if (isListOrMap()) {
+                    // One [size, numElements] record per message, the reader groups them by size
+                    _ndjsonWriter->writeRecord(getListMapSizeRecord(recordedSize));
+                } else {
+                    _ndjsonWriter->writeRecord(recordedSize.first);
+                }
+                return;
             }
-            std::string elt = proton::get<std::string>(testList[0]);
-            uint32_t numElements = testList.size();
-            return std::pair<uint32_t, uint32_t>(numElements * elt.size() / 1024 / 1024, numElements);
-        }
-
-        std::pair<uint32_t, uint32_t> Receiver::getTestMapSizeMb(const proton::value& pvTestMap) {
-            // Uniform elt size assumed
-            const std::map<std::string, proton::value>& testMap(proton::get<std::map<std::string, proton::value> >(pvTestMap));
-            if (testMap.empty()) {
-                std::ostringstream oss;
-                oss << _testName << "::Receiver::getTestMapSizeMb: Map empty";
-                throw qpidit::ArgumentError(oss.str());
+            const std::pair<std::unordered_map<BodySize_t, size_t, BodySizeHash>::iterator, bool> inserted =
+                            _bodySizeIndex.insert(std::make_pair(recordedSize, _bodySizeCounts.size()));
+            if (inserted.second) {
+                _bodySizeCounts.push_back(std::make_pair(recordedSize, 0));
             }
-            std::string elt = proton::get<std::string>(testMap.begin()->second);
-            uint32_t numElements = testMap.size();
-            return std::pair<uint32_t, uint32_t>(numElements * elt.size() / 1024 / 1024, numElements);
+            ++_bodySizeCounts[inserted.first->second].second;
         }
 
-        uint32_t Receiver::getTestStringSizeMb(const proton::value& testString) {
-            if (_amqpType.compare("binary") == 0) {
-                return proton::get<proton::binary>(testString).size() / 1024 / 1024;
+        // Walks the body in place in the proton-c data under it, finding its size and number of elements and
+        // checking every byte against the sender's test pattern, and against the CRC32C annotation if the sender
+        // attached one. Only compound headers and element lengths are read besides the content bytes, which are
+        // checked where they lie, so nothing is copied out or allocated per element. Returns the total size in
+        // bytes of the content (the string/binary/symbol, or all list or map values) and the number of elements,
+        // 1 for binary, string and symbol.
+        std::pair<uint64_t, uint32_t> Receiver::inspectTestBody(const proton::message& m) {
+            // A body sent from a payload file is not the test pattern, so only its CRC32C can be checked
+            const proton::symbol payloadCrc32cKey(TestPattern::s_payloadCrc32cAnnotationKey);
+            const bool checkPattern = !m.message_annotations().exists(payloadCrc32cKey);
+            const proton::symbol crc32cKey(checkPattern ? TestPattern::s_crc32cAnnotationKey : TestPattern::s_payloadCrc32cAnnotationKey);
+            const bool checkCrc32c = m.message_annotations().exists(crc32cKey);
+            const uint32_t expectedCrc32c = checkCrc32c ? proton::get<uint32_t>(m.message_annotations().get(crc32cKey)) : 0;
+            PnData pnData(m.body());
+            pn_data_t* data = pnData.pnData();
+            pn_data_rewind(data);
+            pn_data_next(data);
+            checkDataType(data, _amqpTypeId);
+            uint64_t bodyOffset = 0;
+            uint32_t numElements = 1;
+            switch (_amqpTypeId) {
+            case proton::BINARY:
+                verifyTestBytes(pn_data_get_binary(data), bodyOffset, checkPattern, checkCrc32c, expectedCrc32c);
+                break;
+            case proton::STRING:
+                verifyTestBytes(pn_data_get_string(data), bodyOffset, checkPattern, checkCrc32c, expectedCrc32c);
+                break;
+            case proton::SYMBOL:
+                verifyTestBytes(pn_data_get_symbol(data), bodyOffset, checkPattern, checkCrc32c, expectedCrc32c);
+                break;
+            case proton::LIST: {
+                const size_t count = pn_data_get_list(data);
+                if (count == 0) {
+                    throw qpidit::ArgumentError(MSG(_testName << "::inspectTestBody: List empty"));
+                }
+                numElements = count;
+                pn_data_enter(data);
+                for (size_t i=0; i<count; ++i) {
+                    pn_data_next(data);
+                    checkDataType(data, proton::STRING);
+                    verifyTestBytes(pn_data_get_string(data), bodyOffset, checkPattern, checkCrc32c, expectedCrc32c);
+                }
+                pn_data_exit(data);
+                break;
             }
-            if (_amqpType.compare("string") == 0) {
-                return proton::get<std::string>(testString).size() / 1024 / 1024;
+            case proton::MAP: {
+                const size_t count = pn_data_get_map(data); // keys and values
+                if (count == 0) {
+                    throw qpidit::ArgumentError(MSG(_testName << "::inspectTestBody: Map empty"));
+                }
+                numElements = count / 2;
+                pn_data_enter(data);
+                for (size_t i=0; i<count; i+=2) {
+                    pn_data_next(data); // key
+                    pn_data_next(data);
+                    checkDataType(data, proton::STRING);
+                    verifyTestBytes(pn_data_get_string(data), bodyOffset, checkPattern, checkCrc32c, expectedCrc32c);
+                }
+                pn_data_exit(data);
+                break;
             }
-            if (_amqpType.compare("symbol") == 0) {
-                return proton::get<proton::symbol>(testString).size() / 1024 / 1024;
+            default:
+                break;
             }
-            return 0;
+            return std::pair<uint64_t, uint32_t>(bodyOffset, numElements);
         }
 
-        void Receiver::appendListMapSize(Json::Value& numEltsList, std::pair<uint32_t, uint32_t> val) {
-            numEltsList.append(val.second);
+        // Each element starts the pattern afresh, and the CRC32C covers one element. Both checks are made a chunk
+        // at a time, so the bytes are brought into cache once. bodyOffset counts the bytes verified so far in the
+        // body and locates a mismatch in the error.
+        void Receiver::verifyTestBytes(const pn_bytes_t& bytes,
+                                       uint64_t& bodyOffset,
+                                       bool checkPattern,
+                                       bool checkCrc32c,
+                                       uint32_t expectedCrc32c) {
+            uint32_t crc = 0;
+            for (size_t offset=0; offset<bytes.size; ) {
+                const size_t n = std::min(s_verifyChunkSize, bytes.size - offset);
+                if (checkPattern) {
+                    const size_t verified = TestPattern::verify(bytes.start + offset, n, offset);
+                    if (verified < n) {
+                        throw qpidit::IncorrectMessageBodyContentError(_testName, bodyOffset + offset + verified);
+                    }
+                }
+                if (checkCrc32c) {
+                    crc = Crc32c::extend(crc, bytes.start + offset, n);
+                }
+                offset += n;
+            }
+            if (checkCrc32c && crc != expectedCrc32c) {
+                throw qpidit::IncorrectMessageBodyCrcError(_testName, expectedCrc32c, crc);
+            }
+            bodyOffset += bytes.size;
+        }
+
+        //static
+        void Receiver::checkDataType(pn_data_t* data, proton::type_id expected) {
+            const pn_type_t found = pn_data_type(data);
+            if (found != pn_type_t(expected)) {
+                throw qpidit::IncorrectMessageBodyTypeError(expected, proton::type_id(found));
+            }
+        }
+
+        bool Receiver::isListOrMap() const {
+            return _amqpTypeId == proton::LIST || _amqpTypeId == proton::MAP;
         }
 
-        void Receiver::createNewListMapSize(std::pair<uint32_t, uint32_t> val) {
-            Json::Value sizeVal(Json::arrayValue);
-            sizeVal.append(val.first);
-            Json::Value numEltsList(Json::arrayValue);
-            numEltsList.append(val.second);
-            sizeVal.append(numEltsList);
-            _receivedValueList.append(sizeVal);
+        //static
+        Json::Value Receiver::getListMapSizeRecord(const BodySize_t& bodySize) {
+            Json::Value sizeRecord(Json::arrayValue);
+            sizeRecord.append(bodySize.first);
+            sizeRecord.append(bodySize.second);
+            return sizeRecord;
+        }
+
+        // --- BodySizeHash ---
+
+        size_t Receiver::BodySizeHash::operator()(const BodySize_t& bodySize) const {
+            return std::hash<uint64_t>()((uint64_t(bodySize.first) << 32) | bodySize.second);
         }
 
     } /* namespace amqp_large_content_test */
@@ -160,25 +344,46 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: Expected number of test values to receive
+ *       5+: Options (optional):
+ *           --size-bytes: Report sizes in bytes rather than MB
+ *           --repeat N: Expect the test messages N times over
+ *           --stream: Write a line of JSON for each message as it arrives (NDJSON), after the AMQP type line,
+ *                     followed by a summary line. Records are sizes in MB for binary, string and symbol,
+ *                     and [size in MB, number of elements] for list and map.
+ *           --decode-cost: Time proton's decode and this shim's walk of each body per element, reported in
+ *                          the summary (with --stream) or in the benchmark stats
+ *           --credit-window N: Issue N credits on the link (default: the proton default window)
+ *           --credit-low-water M: Manage credit manually, topping it back up to N once it falls to M
+ *           --ack-batch B: Accept deliveries B at a time (default 1)
+ *       --repeat selects benchmark mode, which prints throughput stats as JSON in place of the received value list
  */
 
 int main(int argc, char** argv) {
     // TODO: improve arg management a little...
-    if (argc != 5) {
+    if (argc < 5) {
         throw qpidit::ArgumentError("Incorrect number of arguments");
     }
 
     try {
-        qpidit::amqp_large_content_test::Receiver receiver(argv[1], argv[2], argv[3], std::strtoul(argv[4], NULL, 0));
-        proton::container(receiver).run();
-
-        std::cout << argv[3] << std::endl;
-        Json::StreamWriterBuilder wbuilder;
-        wbuilder["indentation"] = "";
-        std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
-        std::ostringstream oss;
-        writer->write(receiver.getReceivedValueList(), &oss);
-        std::cout << oss.str() << std::endl;
+        const qpidit::ShimOptions options(argc, argv, 5);
+        qpidit::amqp_large_content_test::Receiver receiver(argv[1], argv[2], argv[3], std::strtoul(argv[4], NULL, 0), options);
+        options.checkAllUsed();
+        if (receiver.isStreaming()) {
+            // Records are written while receiving, so the AMQP type line goes first
+            std::cout << argv[3] << std::endl;
+            proton::container(receiver).run();
+            receiver.writeStreamSummary();
+        } else {
+            proton::container(receiver).run();
+
+            std::cout << argv[3] << std::endl;
+            Json::StreamWriterBuilder wbuilder;
+            wbuilder["indentation"] = "";
+            std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
+            std::ostringstream oss;
+            writer->write(receiver.isBenchmark() ? receiver.getStats() : receiver.getReceivedValueList(), &oss);
+            std::cout << oss.str() << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "amqp_large_content_test receiver error: " << e.what() << std::endl;
         exit(-1);
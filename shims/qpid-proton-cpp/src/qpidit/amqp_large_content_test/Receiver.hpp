@@ -23,8 +23,18 @@
 #define SRC_QPIDIT_AMQP_LARGE_CONTENT_TEST_RECEIVER_HPP_
 
 #include <json/value.h>
+#include <memory>
+#include <proton/codec.h>
+#include <proton/message.hpp>
+#include <proton/type_id.hpp>
 #include <proton/value.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <qpidit/AmqpReceiverBase.hpp>
+#include <qpidit/NdjsonWriter.hpp>
+#include <qpidit/PerfStats.hpp>
+#include <qpidit/ShimOptions.hpp>
 
 namespace qpidit
 {
@@ -34,22 +44,57 @@ namespace qpidit
         class Receiver : public qpidit::AmqpReceiverBase
         {
         protected:
+            // (size, number of elements) of a received test body, 1 element for binary, string and symbol
+            typedef std::pair<uint32_t, uint32_t> BodySize_t;
+            struct BodySizeHash
+            {
+                size_t operator()(const BodySize_t& bodySize) const;
+            };
+
+            static const size_t s_verifyChunkSize;
+
             const std::string _amqpType;
+            const proton::type_id _amqpTypeId;
             uint32_t _expected;
             uint32_t _received;
-            Json::Value _receivedValueList;
+            std::vector<std::pair<BodySize_t, uint32_t> > _bodySizeCounts; // Distinct body sizes in order of first arrival, with the number received
+            std::unordered_map<BodySize_t, size_t, BodySizeHash> _bodySizeIndex; // Index into _bodySizeCounts
+            const bool _sizeBytesFlag; // --size-bytes: report sizes in bytes rather than MB
+            const bool _benchmarkFlag;
+            PerfStats _perfStats;
+            const bool _decodeCostFlag; // --decode-cost: time proton's decode of each body, by decoding it again
+            std::vector<char> _encodedMessage; // Reused for each decode timed
+            uint64_t _decodedElements;
+            int64_t _decodeNs;
+            int64_t _walkNs;
+            std::unique_ptr<NdjsonWriter> _ndjsonWriter; // --stream: write a record for each message as it arrives
         public:
-            Receiver(const std::string& brokerAddr, const std::string& queueName, const std::string& amqpType, uint32_t exptected);
+            Receiver(const std::string& brokerAddr,
+                     const std::string& queueName,
+                     const std::string& amqpType,
+                     uint32_t exptected,
+                     const qpidit::ShimOptions& options);
             virtual ~Receiver();
 
-            Json::Value& getReceivedValueList();
+            Json::Value getReceivedValueList() const;
+            bool isBenchmark() const;
+            Json::Value getStats() const;
+            Json::Value getDecodeCost() const;
+            bool isStreaming() const;
+            void writeStreamSummary();
             void on_message(proton::delivery &d, proton::message &m);
         protected:
-            std::pair<uint32_t, uint32_t> getTestListSizeMb(const proton::value& testList);
-            std::pair<uint32_t, uint32_t> getTestMapSizeMb(const proton::value& testMap);
-            uint32_t getTestStringSizeMb(const proton::value& testString);
-            void appendListMapSize(Json::Value& numEltsList, std::pair<uint32_t, uint32_t> val);
-            void createNewListMapSize(std::pair<uint32_t, uint32_t> val);
+            void timeDecode(const proton::message& m);
+            void recordTestBody(const std::pair<uint64_t, uint32_t>& bodySize);
+            std::pair<uint64_t, uint32_t> inspectTestBody(const proton::message& m);
+            void verifyTestBytes(const pn_bytes_t& bytes,
+                                 uint64_t& bodyOffset,
+                                 bool checkPattern,
+                                 bool checkCrc32c,
+                                 uint32_t expectedCrc32c);
+            static void checkDataType(pn_data_t* data, proton::type_id expected);
+            bool isListOrMap() const;
+            static Json::Value getListMapSizeRecord(const BodySize_t& bodySize);
         };
 
     } /* namespace amqp_large_content_test */
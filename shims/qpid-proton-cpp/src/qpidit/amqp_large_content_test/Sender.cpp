@@ -21,121 +21,451 @@
 
 #include "qpidit/amqp_large_content_test/Sender.hpp"
 
+#include <algorithm>
 #include <cstring>
-#include <iomanip>
+#include <endian.h>
 #include <iostream>
 #include <json/json.h>
+#include <proton/codec/encoder.hpp>
 #include <proton/container.hpp>
 #include <proton/connection.hpp>
 #include <proton/message.hpp>
 #include <proton/sender.hpp>
 #include <proton/tracker.hpp>
+#include <proton/work_queue.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/Crc32c.hpp>
 #include <qpidit/QpidItErrors.hpp>
+#include <qpidit/TestPattern.hpp>
 
 namespace qpidit
 {
     namespace amqp_large_content_test
     {
 
+        // Messages larger than one chunk are streamed, holding at most a few chunks in memory
+        const size_t Sender::s_streamChunkSize = 1024 * 1024;
+        const size_t Sender::s_streamMaxBufferedBytes = 4 * Sender::s_streamChunkSize;
+
         Sender::Sender(const std::string& brokerAddr,
                        const std::string& queueName,
                        const std::string& amqpType,
-                       const Json::Value& testValues) :
+                       const Json::Value& testValues,
+                       const qpidit::ShimOptions& options) :
                         AmqpSenderBase("amqp_large_content_test::Sender", brokerAddr, queueName, testValues.size()),
                         _amqpType(amqpType),
-                        _testValues(testValues)
-        {}
+                        _amqpTypeId(AmqpTypes::typeId(amqpType)),
+                        _testValues(testValues),
+                        _messageSpecs(),
+                        _repeat(getPositiveOption(options, "repeat")),
+                        _benchmarkFlag(options.hasOption("repeat")),
+                        _perfStats()
+        {
+            createMessageSpecs(_messageSpecs, _amqpType, _testValues, options.getFlag("size-bytes") ? 1 : 1024 * 1024);
+            _totalMsgs = _messageSpecs.size() * _repeat;
+            const std::string payloadFileName(options.getString("payload-file", ""));
+            const bool hugePagesFlag = options.getFlag("payload-hugepages");
+            if (!payloadFileName.empty()) {
+                openPayloadFile(payloadFileName, hugePagesFlag);
+            } else if (hugePagesFlag) {
+                throw qpidit::ArgumentError("--payload-hugepages requires --payload-file");
+            }
+        }
 
         Sender::~Sender() {}
 
+        bool Sender::isBenchmark() const {
+            return _benchmarkFlag;
+        }
+
+        Json::Value Sender::getStats() const {
+            Json::Value stats(_perfStats.toJson());
+            if (AllocTracker::isEnabled()) {
+                stats["alloc"] = AllocTracker::toJson();
+            }
+            return stats;
+        }
+
         void Sender::on_sendable(proton::sender &s) {
-            if (_totalMsgs == 0) {
-                s.connection().close();
-            } else if (_msgsSent == 0) {
-                for (Json::Value::const_iterator i=_testValues.begin(); i!=_testValues.end(); ++i) {
-                    if (s.credit()) {
-                        uint32_t totSizeMb;
-                        Json::Value numElementsList = Json::arrayValue;
-                        if ((*i).isInt()) {
-                            totSizeMb = (*i).asInt();
-                            numElementsList.append(1);
-                        } else if ((*i).isArray()) {
-                            totSizeMb = (*i)[0].asInt();
-                            numElementsList = (*i)[1];
-                        } else {
-                            std::cerr << "on_sendable: Unexpected JSON type: " << (*i).type() << std::endl;
-                        }
-                        for (Json::Value::iterator numElementsAsStrItr=numElementsList.begin();
-                                                   numElementsAsStrItr!=numElementsList.end();
-                                                   ++numElementsAsStrItr) {
-                            proton::message msg;
-                            setMessage(msg, totSizeMb * 1024 * 1024, (*numElementsAsStrItr).asInt());
-                            s.send(msg);
-                            _msgsSent++;
-                        }
-                    }
+            AllocTracker::advancePhase(AllocTracker::TRANSFER);
+            if (_benchmarkFlag && !_perfStats.isStarted()) {
+                _perfStats.start();
+            }
+            // While a message is being streamed, the next is started once it is complete
+            if (!_streamedMessage) {
+                sendMessages(s);
+            }
+            const uint32_t linkIndex = getLinkIndex(s);
+            checkLinkDone(_linkShards[linkIndex], linkIndex);
+            stopStatsOnCompletion();
+        }
+
+        void Sender::on_tracker_accept(proton::tracker &t) {
+            AmqpSenderBase::on_tracker_accept(t);
+            stopStatsOnCompletion();
+        }
+
+        // protected
+
+        // The test messages are sent _repeat times over
+        const MessageSpec_t& Sender::getMessageSpec(uint32_t msgNum) const {
+            return _messageSpecs[msgNum % _messageSpecs.size()];
+        }
+
+        // Bodies are the start of the file, as long as each one needs. Their CRC32Cs are found here in a single
+        // pass over the file, extending the CRC of each size to the next larger one.
+        // Binary only: arbitrary file bytes are not valid UTF-8, so as a string body other clients could not decode them.
+        void Sender::openPayloadFile(const std::string& fileName, bool hugePagesFlag) {
+            if (_amqpTypeId != proton::BINARY) {
+                throw qpidit::ArgumentError(MSG("--payload-file is supported for binary only, not " << _amqpType));
+            }
+            _payloadFile.reset(new MappedFile(fileName, hugePagesFlag));
+            for (std::vector<MessageSpec_t>::const_iterator i=_messageSpecs.begin(); i!=_messageSpecs.end(); ++i) {
+                if (i->first > _payloadFile->size()) {
+                    throw qpidit::ArgumentError(MSG("Payload file \"" << fileName << "\" of " << _payloadFile->size()
+                                                    << " bytes is smaller than the " << i->first << " byte test value"));
+                }
+                _payloadCrc32cs[i->first] = 0;
+            }
+            uint32_t crc = 0;
+            uint32_t crcSize = 0;
+            for (std::map<uint32_t, uint32_t>::iterator i=_payloadCrc32cs.begin(); i!=_payloadCrc32cs.end(); ++i) {
+                crc = Crc32c::extend(crc, _payloadFile->data() + crcSize, i->first - crcSize);
+                crcSize = i->first;
+                i->second = crc;
+            }
+        }
+
+        Sender::TestBodySource* Sender::createTestBodySource(const MessageSpec_t& messageSpec) const {
+            if (_payloadFile) {
+                return new TestBodySource(_amqpTypeId, messageSpec.first, _payloadFile->data(),
+                                          _payloadCrc32cs.find(messageSpec.first)->second);
+            }
+            return new TestBodySource(_amqpTypeId, messageSpec.first, messageSpec.second);
+        }
+
+        // Send time runs from the first credit to the last message being accepted
+        void Sender::stopStatsOnCompletion() {
+            if (!_benchmarkFlag || !isComplete() || _perfStats.isStopped()) return;
+            _perfStats.stop();
+            for (uint32_t msgNum=0; msgNum<_totalMsgs; ++msgNum) {
+                _perfStats.add(1, getMessageSpec(msgNum).first);
+            }
+        }
+
+        // Sends whole messages until one needs streaming, which holds the link until it is written
+        void Sender::sendMessages(proton::sender& s) {
+            LinkShard& linkShard = _linkShards[getLinkIndex(s)];
+            uint32_t msgNum;
+            while (!_streamedMessage && s.credit() > 0 && claimMessages(1, msgNum) > 0) {
+                const MessageSpec_t& messageSpec = getMessageSpec(msgNum);
+                std::unique_ptr<TestBodySource> source(createTestBodySource(messageSpec));
+                linkShard.msgsSent++;
+                if (source->size() <= s_streamChunkSize) {
+                    proton::message msg;
+                    setMessage(msg, msgNum);
+                    s.send(msg);
+                    continue;
                 }
+                _streamedMessage.reset(new StreamedMessage(source.release(), s_streamChunkSize, s_streamMaxBufferedBytes));
+                if (_streamedMessage->start(s, s_rawDeliveryTagBit | msgNum)) {
+                    _streamedMessage.reset();
+                } else {
+                    s.work_queue().schedule(proton::duration::MILLISECOND, [this, s]() { continueStreaming(s); });
+                }
+            }
+        }
+
+        // Runs on the connection's work queue until the transport has drained the whole message
+        void Sender::continueStreaming(proton::sender s) {
+            if (!_streamedMessage) return;
+            if (!s.active()) {
+                _streamedMessage.reset(); // Link closed part way through the message
+                return;
+            }
+            if (_streamedMessage->write(s)) {
+                _streamedMessage.reset();
+                sendMessages(s);
             } else {
-                // do nothing
+                s.work_queue().schedule(proton::duration::MILLISECOND, [this, s]() { continueStreaming(s); });
             }
         }
 
-        // protected
+        proton::message& Sender::setMessage(proton::message& msg, uint32_t msgNum) {
+            const MessageSpec_t& messageSpec = getMessageSpec(msgNum);
+            return setMessage(msg, messageSpec.first, messageSpec.second);
+        }
 
         proton::message& Sender::setMessage(proton::message& msg,
                                             uint32_t totSizeBytes,
                                             uint32_t numElements) {
-            if (_amqpType.compare("binary") == 0) {
-                proton::binary val(createTestString(totSizeBytes));
-                msg.body(val);
-            } else if (_amqpType.compare("string") == 0) {
-                msg.body(createTestString(totSizeBytes));
-            } else if (_amqpType.compare("symbol") == 0) {
-                proton::symbol val(createTestString(totSizeBytes));
-                msg.body(val);
-            } else if (_amqpType.compare("list") == 0) {
-                std::vector<proton::value> testList;
-                createTestList(testList, totSizeBytes, numElements);
-                msg.body(testList);
-            } else if (_amqpType.compare("map") == 0) {
-                std::map<std::string, proton::value> testMap;
-                createTestMap(testMap, totSizeBytes, numElements);
-                msg.body(testMap);
-            }
-           return msg;
+            if (_payloadFile) {
+                // Only messages within one stream chunk get here, larger ones are streamed from the file in place
+                const char* payload = _payloadFile->data();
+                msg.body(proton::binary(payload, payload + totSizeBytes));
+                msg.message_annotations().put(proton::symbol(TestPattern::s_payloadCrc32cAnnotationKey),
+                                              _payloadCrc32cs.find(totSizeBytes)->second);
+                return msg;
+            }
+            switch (_amqpTypeId) {
+            case proton::BINARY:
+                msg.body(createTestBody<proton::binary>(totSizeBytes));
+                break;
+            case proton::STRING:
+                msg.body(createTestBody<std::string>(totSizeBytes));
+                break;
+            case proton::SYMBOL:
+                msg.body(createTestBody<proton::symbol>(totSizeBytes));
+                break;
+            case proton::LIST:
+            case proton::MAP:
+                setTestCompoundBody(msg.body(), _amqpTypeId == proton::MAP, totSizeBytes, numElements);
+                break;
+            default:
+                return msg; // No body to checksum
+            }
+            // Every element has the same content, so one CRC covers them all
+            msg.message_annotations().put(proton::symbol(TestPattern::s_crc32cAnnotationKey),
+                                          TestPattern::crc32c(totSizeBytes / numElements));
+            return msg;
         }
 
         // static
-        void Sender::createTestList(std::vector<proton::value>& testList,
-                                    uint32_t totSizeBytes,
-                                    uint32_t numElements) {
+        void Sender::createMessageSpecs(std::vector<MessageSpec_t>& messageSpecs,
+                                        const std::string& amqpType,
+                                        const Json::Value& testValues,
+                                        uint32_t sizeUnitBytes) {
+            // Test values are either a total size in MB (or bytes, see sizeUnitBytes) with a single element, or a
+            // JSON array [total size, [num elements, num elements, ...]] which produces one message per element count
+            for (Json::Value::const_iterator i=testValues.begin(); i!=testValues.end(); ++i) {
+                if ((*i).isIntegral()) {
+                    messageSpecs.push_back(MessageSpec_t(getSizeBytes(amqpType, *i, sizeUnitBytes), 1));
+                } else if ((*i).isArray()) {
+                    const uint32_t totSizeBytes = getSizeBytes(amqpType, (*i)[0], sizeUnitBytes);
+                    const Json::Value& numElementsList = (*i)[1];
+                    for (Json::Value::const_iterator j=numElementsList.begin(); j!=numElementsList.end(); ++j) {
+                        messageSpecs.push_back(MessageSpec_t(totSizeBytes, (*j).asInt()));
+                    }
+                } else {
+                    throw qpidit::InvalidTestValueError(amqpType, (*i).toStyledString());
+                }
+            }
+        }
 
-            uint32_t sizePerEltBytes = totSizeBytes / numElements;
-            for (uint32_t i=0; i<numElements; ++i) {
-                testList.push_back(createTestString(sizePerEltBytes));
+        // static
+        uint32_t Sender::getSizeBytes(const std::string& amqpType, const Json::Value& size, uint32_t sizeUnitBytes) {
+            const uint64_t sizeBytes = uint64_t(size.asUInt()) * sizeUnitBytes;
+            if (sizeBytes > UINT32_MAX) {
+                throw qpidit::InvalidTestValueError(amqpType, size.toStyledString());
             }
+            return sizeBytes;
         }
 
         // static
-        void Sender::createTestMap(std::map<std::string, proton::value>& testMap,
-                                   uint32_t totSizeBytes,
-                                   uint32_t numElements) {
+        // Encodes the list or map straight into body in a single pass, without building a std::vector or std::map
+        // of proton::value first. Map keys are generated in sorted order, which is the order a std::map would have
+        // encoded them in.
+        void Sender::setTestCompoundBody(proton::value& body,
+                                         bool mapFlag,
+                                         uint32_t totSizeBytes,
+                                         uint32_t numElements) {
+            // Every element has the same content, so it is generated once
+            const std::string elt(createTestBody<std::string>(totSizeBytes / numElements));
+            proton::codec::encoder encoder(body);
+            if (mapFlag) {
+                encoder << proton::codec::start::map();
+                KeyGenerator keyGenerator(numElements);
+                std::string key;
+                for (uint32_t i=0; i<numElements; ++i, keyGenerator.next()) {
+                    key.assign(keyGenerator.data(), keyGenerator.size());
+                    encoder << key << elt;
+                }
+            } else {
+                encoder << proton::codec::start::list();
+                for (uint32_t i=0; i<numElements; ++i) {
+                    encoder << elt;
+                }
+            }
+            encoder << proton::codec::finish();
+        }
 
-            uint32_t sizePerEltBytes = totSizeBytes / numElements;
-            for (uint32_t i=0; i<numElements; ++i) {
-                std::ostringstream oss;
-                oss << "elt_" << std::setw(6) << std::setfill('0') << i;
-                testMap[oss.str()] = createTestString(sizePerEltBytes);
+        // --- KeyGenerator ---
+
+        Sender::KeyGenerator::KeyGenerator(uint32_t numKeys) :
+                        _size(s_prefixSize + s_minDigits)
+        {
+            for (uint32_t n=numKeys-1; n>=1000000; n/=10) {
+                ++_size;
             }
+            std::memcpy(_key, "elt_", s_prefixSize);
+            std::memset(_key + s_prefixSize, '0', _size - s_prefixSize);
         }
 
-        //static
-        std::string Sender::createTestString(uint32_t msgSizeBytes) {
-            std::ostringstream oss;
-            for (uint32_t i=0; i<msgSizeBytes; ++i) {
-                oss << char('a' + (i%26));
+        // Increments the number in place, like an odometer
+        void Sender::KeyGenerator::next() {
+            for (char* digit=_key+_size-1; digit>=_key+s_prefixSize; --digit) {
+                if (*digit != '9') {
+                    ++*digit;
+                    return;
+                }
+                *digit = '0';
+            }
+        }
+
+        // --- TestBodySource ---
+
+        const std::string Sender::TestBodySource::s_amqpValueSection("\x00\x53\x77", 3);
+
+        // Encodes the same message as setMessage(): the CRC32C annotation, then binary/string/symbol as
+        // vbin32/str32/sym32, list as a list32 of str32 elements, and map as a map32 of str8 keys (see
+        // KeyGenerator) to str32 values. Binary, string and symbol are treated as a single element with no header.
+        Sender::TestBodySource::TestBodySource(proton::type_id amqpTypeId, uint32_t totSizeBytes, uint32_t numElements) :
+                        _prefix(),
+                        _payload(0),
+                        _numElements(0),
+                        _eltPatternSize(0),
+                        _eltHeader(),
+                        _keyGenerator(),
+                        _size(0),
+                        _prefixOffset(0),
+                        _eltIndex(0),
+                        _eltOffset(0)
+        {
+            _prefix = encodeCrc32cAnnotation(TestPattern::s_crc32cAnnotationKey, TestPattern::crc32c(totSizeBytes / numElements)) +
+                      s_amqpValueSection;
+            switch (amqpTypeId) {
+            case proton::BINARY:
+            case proton::STRING:
+            case proton::SYMBOL:
+                _prefix += getConstructor(amqpTypeId) + encodeUInt32(totSizeBytes);
+                _numElements = 1;
+                _eltPatternSize = totSizeBytes;
+                break;
+            case proton::LIST:
+            case proton::MAP: {
+                const bool mapFlag = amqpTypeId == proton::MAP;
+                _numElements = numElements;
+                _eltPatternSize = totSizeBytes / numElements;
+                if (mapFlag) {
+                    _keyGenerator.reset(new KeyGenerator(numElements));
+                    _eltHeader = std::string(1, '\xa1') + char(_keyGenerator->size()) +
+                                 std::string(_keyGenerator->data(), _keyGenerator->size());
+                }
+                _eltHeader += '\xb1' + encodeUInt32(_eltPatternSize);
+                const uint64_t compoundSize = 4 + uint64_t(numElements) * (_eltHeader.size() + _eltPatternSize); // count, elements
+                if (compoundSize > UINT32_MAX) {
+                    throw qpidit::ArgumentError(MSG("Test " << (mapFlag ? "map" : "list") << " of " << totSizeBytes
+                                                    << " bytes in " << numElements << " elements exceeds the maximum encoded size"));
+                }
+                _prefix += (mapFlag ? '\xd1' : '\xd0') + encodeUInt32(compoundSize) +
+                           encodeUInt32(mapFlag ? 2 * numElements : numElements);
+                break;
+            }
+            default:
+                break; // No body, as for setMessage()
+            }
+            _size = _prefix.size() + uint64_t(_numElements) * (_eltHeader.size() + _eltPatternSize);
+        }
+
+        // A binary body of the first totSizeBytes of payload, with its CRC32C under
+        // TestPattern::s_payloadCrc32cAnnotationKey so that the receiver does not expect the test pattern
+        Sender::TestBodySource::TestBodySource(proton::type_id amqpTypeId,
+                                               uint32_t totSizeBytes,
+                                               const char* payload,
+                                               uint32_t payloadCrc32c) :
+                        _prefix(encodeCrc32cAnnotation(TestPattern::s_payloadCrc32cAnnotationKey, payloadCrc32c) +
+                                s_amqpValueSection + getConstructor(amqpTypeId) + encodeUInt32(totSizeBytes)),
+                        _payload(payload),
+                        _numElements(1),
+                        _eltPatternSize(totSizeBytes),
+                        _eltHeader(),
+                        _keyGenerator(),
+                        _size(_prefix.size() + totSizeBytes),
+                        _prefixOffset(0),
+                        _eltIndex(0),
+                        _eltOffset(0)
+        {}
+
+        Sender::TestBodySource::~TestBodySource() {}
+
+        uint64_t Sender::TestBodySource::size() const {
+            return _size;
+        }
+
+        void Sender::TestBodySource::read(char* buf, size_t size) {
+            while (size > 0 && (_prefixOffset < _prefix.size() || _eltIndex < _numElements)) {
+                size_t n;
+                if (_prefixOffset < _prefix.size()) {
+                    n = std::min(size, size_t(_prefix.size() - _prefixOffset));
+                    std::memcpy(buf, _prefix.data() + _prefixOffset, n);
+                    _prefixOffset += n;
+                } else {
+                    if (_eltOffset < _eltHeader.size()) {
+                        n = std::min(size, size_t(_eltHeader.size() - _eltOffset));
+                        std::memcpy(buf, _eltHeader.data() + _eltOffset, n);
+                    } else {
+                        const uint64_t patternOffset = _eltOffset - _eltHeader.size();
+                        n = std::min(uint64_t(size), _eltPatternSize - patternOffset);
+                        if (_payload != 0) {
+                            std::memcpy(buf, _payload + patternOffset, n);
+                        } else {
+                            TestPattern::fill(buf, n, patternOffset);
+                        }
+                    }
+                    _eltOffset += n;
+                    if (_eltOffset == _eltHeader.size() + _eltPatternSize) {
+                        nextElement();
+                    }
+                }
+                buf += n;
+                size -= n;
+            }
+        }
+
+        // Only payload bytes are held in memory, so a peek succeeds once the prefix and element header have been read
+        const char* Sender::TestBodySource::peek(size_t size) {
+            if (_payload == 0 || _prefixOffset < _prefix.size() || _eltIndex >= _numElements ||
+                _eltOffset < _eltHeader.size() || _eltOffset + size > _eltHeader.size() + _eltPatternSize) {
+                return 0;
+            }
+            const char* bytes = _payload + (_eltOffset - _eltHeader.size());
+            _eltOffset += size;
+            if (_eltOffset == _eltHeader.size() + _eltPatternSize) {
+                nextElement();
+            }
+            return bytes;
+        }
+
+        // protected
+
+        // Rewrites the key in the element header in place, the header of every element is the same size
+        void Sender::TestBodySource::nextElement() {
+            ++_eltIndex;
+            _eltOffset = 0;
+            if (_keyGenerator) {
+                _keyGenerator->next();
+                std::memcpy(&_eltHeader[2], _keyGenerator->data(), _keyGenerator->size());
             }
-            return oss.str();
+        }
+
+        //static
+        // vbin32, str32 or sym32
+        char Sender::TestBodySource::getConstructor(proton::type_id amqpTypeId) {
+            return amqpTypeId == proton::BINARY ? '\xb0' : amqpTypeId == proton::STRING ? '\xb1' : '\xb3';
+        }
+
+        //static
+        // A message-annotations section holding only the annotation key (sym8) with value crc (uint)
+        std::string Sender::TestBodySource::encodeCrc32cAnnotation(const std::string& key, uint32_t crc) {
+            const std::string entries(std::string(1, '\xa3') + char(key.size()) + key + '\x70' + encodeUInt32(crc));
+            return std::string("\x00\x53\x72\xd1", 4) + encodeUInt32(4 + entries.size()) + encodeUInt32(2) + entries;
+        }
+
+        //static
+        std::string Sender::TestBodySource::encodeUInt32(uint32_t val) {
+            const uint32_t beVal = htobe32(val);
+            return std::string(reinterpret_cast<const char*>(&beVal), sizeof(beVal));
         }
 
    } /* namespace amqp_large_content_test */
@@ -148,14 +478,22 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: Test value(s) as JSON string
+ *       5+: Options (optional):
+ *           --size-bytes: Test value sizes are in bytes rather than MB
+ *           --repeat N: Send the test messages N times over
+ *           --payload-file PATH: Send binary bodies from the start of file PATH rather than the test
+ *               pattern. The receiver checks their CRC32C only.
+ *           --payload-hugepages: Hold the payload file in huge pages rather than mapping it
+ *       --repeat selects benchmark mode, which prints throughput stats as JSON
  */
 
 int main(int argc, char** argv) {
     try {
         // TODO: improve arg management a little...
-        if (argc != 5) {
+        if (argc < 5) {
             throw qpidit::ArgumentError("Incorrect number of arguments");
         }
+        const qpidit::ShimOptions options(argc, argv, 5);
 
         Json::Value testValues;
         Json::CharReaderBuilder builder;
@@ -165,8 +503,18 @@ int main(int argc, char** argv) {
             throw qpidit::JsonParserError(parseErrors);
         }
 
-        qpidit::amqp_large_content_test::Sender sender(argv[1], argv[2], argv[3], testValues);
+        qpidit::amqp_large_content_test::Sender sender(argv[1], argv[2], argv[3], testValues, options);
+        options.checkAllUsed();
         proton::container(sender).run();
+
+        if (sender.isBenchmark()) {
+            Json::StreamWriterBuilder wbuilder;
+            wbuilder["indentation"] = "";
+            std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
+            std::ostringstream oss;
+            writer->write(sender.getStats(), &oss);
+            std::cout << oss.str() << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "amqp_large_content_test Sender error: " << e.what() << std::endl;
         exit(1);
@@ -23,40 +23,139 @@
 #define SRC_QPIDIT_AMQP_LARGE_CONTENT_TEST_SENDER_HPP_
 
 #include <json/value.h>
+#include <map>
+#include <memory>
+#include <utility>
+#include <proton/type_id.hpp>
 #include <proton/value.hpp>
+#include <vector>
 #include <qpidit/AmqpSenderBase.hpp>
+#include <qpidit/MappedFile.hpp>
+#include <qpidit/PerfStats.hpp>
+#include <qpidit/ShimOptions.hpp>
+#include <qpidit/StreamedMessage.hpp>
+#include <qpidit/TestPattern.hpp>
 
 namespace qpidit
 {
     namespace amqp_large_content_test
     {
 
+        // Pair of (total size in bytes, number of elements) describing a single test message
+        typedef std::pair<uint32_t, uint32_t> MessageSpec_t;
+
         class Sender : public qpidit::AmqpSenderBase
         {
         protected:
+            // Generates the map keys "elt_NNNNNN" in order into one reused buffer. The numbers are zero-padded to
+            // the same width, at least 6 digits, so that the keys sort as their numbers do.
+            class KeyGenerator
+            {
+            protected:
+                static const size_t s_prefixSize = 4;
+                static const size_t s_minDigits = 6;
+                char _key[s_prefixSize + 10];
+                size_t _size;
+            public:
+                explicit KeyGenerator(uint32_t numKeys);
+                inline const char* data() const { return _key; }
+                inline size_t size() const { return _size; }
+                void next();
+            };
+
+            // A whole encoded test message, consisting of a message annotations section holding the CRC32C
+            // annotation and an AMQP value section holding the test body.
+            // The test pattern and the list or map element headers are generated as the bytes are read, so
+            // neither the body nor anything per element is held in memory. A binary body may instead
+            // come from a payload file already in memory, which is handed out in place by peek().
+            class TestBodySource : public StreamedMessage::Source
+            {
+            protected:
+                static const std::string s_amqpValueSection;
+
+                std::string _prefix; // Sections up to the body's constructor and size (and count)
+                const char* _payload; // Element content, when not the test pattern
+                uint32_t _numElements;
+                uint32_t _eltPatternSize;
+                std::string _eltHeader; // Map key (if any) and value constructor of the current element
+                std::unique_ptr<KeyGenerator> _keyGenerator; // Map only
+                uint64_t _size;
+                uint64_t _prefixOffset;
+                uint32_t _eltIndex;
+                uint64_t _eltOffset;
+
+            public:
+                TestBodySource(proton::type_id amqpTypeId, uint32_t totSizeBytes, uint32_t numElements);
+                TestBodySource(proton::type_id amqpTypeId, uint32_t totSizeBytes, const char* payload, uint32_t payloadCrc32c);
+                virtual ~TestBodySource();
+                uint64_t size() const;
+                void read(char* buf, size_t size);
+                const char* peek(size_t size);
+
+            protected:
+                void nextElement();
+                static char getConstructor(proton::type_id amqpTypeId);
+                static std::string encodeCrc32cAnnotation(const std::string& key, uint32_t crc);
+                static std::string encodeUInt32(uint32_t val);
+            };
+
+            static const size_t s_streamChunkSize;
+            static const size_t s_streamMaxBufferedBytes;
+
             const std::string _amqpType;
+            const proton::type_id _amqpTypeId; // _amqpType resolved once
             const Json::Value _testValues;
+            std::vector<MessageSpec_t> _messageSpecs;
+            const uint32_t _repeat; // --repeat N: send the test messages N times
+            const bool _benchmarkFlag;
+            PerfStats _perfStats;
+            std::unique_ptr<StreamedMessage> _streamedMessage; // The message being streamed, if any
+            std::unique_ptr<MappedFile> _payloadFile; // --payload-file: binary bodies are sent from here
+            std::map<uint32_t, uint32_t> _payloadCrc32cs; // Body size to CRC32C of that many bytes of _payloadFile
 
         public:
             Sender(const std::string& brokerAddr,
                    const std::string& queueName,
                    const std::string& amqpType,
-                   const Json::Value& testValues);
+                   const Json::Value& testValues,
+                   const qpidit::ShimOptions& options);
             virtual ~Sender();
 
+            bool isBenchmark() const;
+            Json::Value getStats() const;
             void on_sendable(proton::sender &s);
+            void on_tracker_accept(proton::tracker &t);
 
         protected:
+            void sendMessages(proton::sender& s);
+            void continueStreaming(proton::sender s);
+            const MessageSpec_t& getMessageSpec(uint32_t msgNum) const;
+            void openPayloadFile(const std::string& fileName, bool hugePagesFlag);
+            TestBodySource* createTestBodySource(const MessageSpec_t& messageSpec) const;
+            void stopStatsOnCompletion();
+            proton::message& setMessage(proton::message& msg, uint32_t msgNum);
             proton::message& setMessage(proton::message& msg,
                                         uint32_t totSizeBytes,
                                         uint32_t numElements);
-            static void createTestList(std::vector<proton::value>& testList,
-                                       uint32_t totSizeBytes,
-                                       uint32_t numElements);
-            static void createTestMap(std::map<std::string, proton::value>& testMap,
-                                      uint32_t totSizeBytes,
-                                      uint32_t numElements);
-            static std::string createTestString(uint32_t msgSizeBytes);
+            static void createMessageSpecs(std::vector<MessageSpec_t>& messageSpecs,
+                                           const std::string& amqpType,
+                                           const Json::Value& testValues,
+                                           uint32_t sizeUnitBytes);
+            static uint32_t getSizeBytes(const std::string& amqpType, const Json::Value& size, uint32_t sizeUnitBytes);
+            static void setTestCompoundBody(proton::value& body,
+                                            bool mapFlag,
+                                            uint32_t totSizeBytes,
+                                            uint32_t numElements);
+
+            // T is std::string, proton::binary or proton::symbol, generated in place in the final body type
+            template<typename T> static T createTestBody(uint32_t sizeBytes) {
+                T body;
+                body.resize(sizeBytes);
+                if (sizeBytes > 0) {
+                    TestPattern::fill(reinterpret_cast<char*>(&body[0]), sizeBytes);
+                }
+                return body;
+            }
         };
 
     } /* namespace amqp_large_content_test */
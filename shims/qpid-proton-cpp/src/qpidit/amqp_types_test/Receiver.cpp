@@ -22,6 +22,9 @@
 #include <qpidit/amqp_types_test/Receiver.hpp>
 #include "qpidit/Base64.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
 #include <iostream>
 #include <json/json.h>
 #include <proton/connection.hpp>
@@ -32,24 +35,55 @@
 #include <proton/receiver.hpp>
 #include <proton/thread_safe.hpp>
 #include <proton/transport.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/PnData.hpp>
 #include <qpidit/QpidItErrors.hpp>
+#include <sstream>
 
 namespace qpidit
 {
     namespace amqp_types_test
     {
 
-        Receiver::Receiver(const std::string& brokerUrl,
+        Receiver::LinkStats::LinkStats() :
+                        msgCount(0),
+                        byteCount(0),
+                        unstampedCount(0),
+                        latencyHistogram()
+        {}
+
+        Receiver::Receiver(const std::string& brokerAddr,
                            const std::string& queueName,
                            const std::string& amqpType,
-                           uint32_t expected) :
-                        _brokerUrl(brokerUrl),
-                        _queueName(queueName),
+                           uint32_t expected,
+                           const qpidit::ShimOptions& options) :
+                        qpidit::AmqpReceiverBase("amqp_types_test::Receiver", brokerAddr, queueName, options),
                         _amqpType(amqpType),
-                        _expected(expected),
+                        _amqpTypeId(AmqpTypes::typeId(amqpType)),
+                        _valueBuffer(),
+                        _expected(options.getUInt("warmup", 0) + options.getUInt("repeat", 1) * expected),
                         _received(0UL),
-                        _receivedValueList(Json::arrayValue)
-        {}
+                        _receivedValueList(Json::arrayValue),
+                        _warmupMsgs(options.getUInt("warmup", 0)),
+                        _untilEndMarker(options.hasOption("duration")),
+                        _endMarkers(0),
+                        _senderLinks(0),
+                        _sentMsgs(0),
+                        _timedRunDone(false),
+                        _latencyFlag(options.getFlag("latency")),
+                        _benchmarkFlag(options.hasOption("repeat") || options.hasOption("duration") || options.hasOption("warmup") ||
+                                       _latencyFlag),
+                        _statsMutex(),
+                        _perfStats(),
+                        _linkStats(getNumLinks()),
+                        _ndjsonWriter(options.getFlag("stream") ? new NdjsonWriter(std::cout) : 0)
+        {
+            if (!_benchmarkFlag && getNumLinks() > 1) {
+                // The received value list is compared in send order, which only a single link preserves
+                throw qpidit::ArgumentError("Multiple links are only supported in benchmark mode");
+            }
+        }
 
         Receiver::~Receiver() {}
 
@@ -57,50 +91,152 @@ namespace qpidit
             return _receivedValueList;
         }
 
-        void Receiver::on_container_start(proton::container &c) {
-            std::ostringstream oss;
-            oss << _brokerUrl << "/" << _queueName;
-            c.open_receiver(oss.str());
+        bool Receiver::isBenchmark() const {
+            return _benchmarkFlag;
+        }
+
+        Json::Value Receiver::getStats() const {
+            PerfStats perfStats(_perfStats);
+            LatencyHistogram latencyHistogram;
+            uint64_t unstampedCount = 0;
+            for (LinkStatsList_t::const_iterator i=_linkStats.begin(); i!=_linkStats.end(); ++i) {
+                perfStats.add(i->msgCount, i->byteCount);
+                latencyHistogram.merge(i->latencyHistogram);
+                unstampedCount += i->unstampedCount;
+            }
+            Json::Value stats(perfStats.toJson());
+            if (_latencyFlag) {
+                stats["latency"] = latencyHistogram.toJson();
+                stats["latency"]["unstampedCount"] = Json::UInt64(unstampedCount);
+            }
+            if (AllocTracker::isEnabled()) {
+                stats["alloc"] = AllocTracker::toJson();
+            }
+            return stats;
+        }
+
+        bool Receiver::isStreaming() const {
+            return _ndjsonWriter.get() != 0;
+        }
+
+        // The summary carries the benchmark stats, if any, in place of a received value list
+        void Receiver::writeStreamSummary() {
+            Json::Value summary(Json::objectValue);
+            if (_benchmarkFlag) {
+                summary["stats"] = getStats();
+            }
+            _ndjsonWriter->writeSummary(summary);
         }
 
         void Receiver::on_message(proton::delivery &d, proton::message &m) {
             try {
-                if (_received < _expected) {
-                    _receivedValueList.append(getValue(_amqpType, m.body()));
+                bool doneFlag;
+                if (_benchmarkFlag) {
+                    doneFlag = measureMessage(d, m);
+                } else {
+                    if (_received < _expected) {
+                        if (_ndjsonWriter) {
+                            _ndjsonWriter->writeRecord(getValue(m.body()));
+                        } else {
+                            _receivedValueList.append(getValue(m.body()));
+                        }
+                    }
+                    doneFlag = ++_received == _expected;
                 }
-                _received++;
-                if (_received >= _expected) {
-                    d.receiver().close();
-                    d.connection().close();
+                messageProcessed(d);
+                if (doneFlag) {
+                    closeConnections();
                 }
             } catch (const std::exception&) {
-                d.receiver().close();
-                d.connection().close();
+                closeConnections();
                 throw;
             }
         }
 
-        void Receiver::on_connection_error(proton::connection &c) {
-            std::cerr << "AmqpReceiver::on_connection_error(): " << c.error() << std::endl;
-        }
+        // protected
 
-        void Receiver::on_receiver_error(proton::receiver& r) {
-            std::cerr << "AmqpReceiver::on_receiver_error(): " << r.error() << std::endl;
+        // Count m in the benchmark stats of its link without keeping its value, returns true once the run is
+        // complete, which happens for exactly one message. The clock starts when the last warmup message
+        // arrives, so that the first message counted is the one after it, as on the sender. Without a warmup
+        // it starts when the first message arrives, which is then counted.
+        bool Receiver::measureMessage(proton::delivery& d, proton::message& m) {
+            const int64_t receiveTimeNs = _latencyFlag ? PerfStats::monotonicNs() : 0;
+            if (_untilEndMarker && m.subject() == PerfStats::s_endMarkerSubject) {
+                addEndMarker(m);
+                return isTimedRunDone();
+            }
+            if (m.body().type() != _amqpTypeId) {
+                throw qpidit::IncorrectMessageBodyTypeError(_amqpType, getAmqpType(m.body()));
+            }
+            const uint32_t received = ++_received;
+            if (received == std::max(_warmupMsgs, 1U)) {
+                startStats();
+            }
+            if (received > _warmupMsgs) {
+                LinkStats& linkStats = _linkStats[getLinkIndex(d.receiver())];
+                linkStats.msgCount++;
+                linkStats.byteCount += PnData::encodedSize(m.body());
+                if (_latencyFlag) {
+                    // A sender run without --latency does not stamp its messages
+                    if (m.properties().exists(PerfStats::s_sendTimeProperty)) {
+                        const proton::scalar sendTimeNs(m.properties().get(PerfStats::s_sendTimeProperty));
+                        linkStats.latencyHistogram.record(receiveTimeNs - proton::get<int64_t>(sendTimeNs));
+                    } else {
+                        linkStats.unstampedCount++;
+                    }
+                }
+            }
+            if (_untilEndMarker) {
+                return isTimedRunDone();
+            }
+            if (received == _expected) {
+                stopStats();
+                return true;
+            }
+            return false;
         }
 
-        void Receiver::on_session_error(proton::session &s) {
-            std::cerr << "AmqpReceiver::on_session_error(): " << s.error() << std::endl;
+        void Receiver::addEndMarker(const proton::message& m) {
+            // A marker without the counts ends the run on its own
+            uint32_t senderLinks = 1;
+            uint32_t linkMsgs = 0;
+            if (m.properties().exists(PerfStats::s_endMarkerLinksProperty)) {
+                senderLinks = proton::get<uint32_t>(m.properties().get(PerfStats::s_endMarkerLinksProperty));
+                linkMsgs = proton::get<uint32_t>(m.properties().get(PerfStats::s_endMarkerMsgsProperty));
+            }
+            // Counted last, so that isTimedRunDone() never sees the marker without the messages sent before it
+            _sentMsgs += linkMsgs;
+            _senderLinks = senderLinks;
+            ++_endMarkers;
         }
 
-        void Receiver::on_transport_error(proton::transport &t) {
-            std::cerr << "AmqpReceiver::on_transport_error(): " << t.error() << std::endl;
+        // A timed run is done once the end marker of every sender link has arrived, along with every message
+        // sent before them: an end marker follows the messages of its own link, but may overtake those of
+        // other links. Returns true for exactly one message.
+        bool Receiver::isTimedRunDone() {
+            const uint32_t senderLinks = _senderLinks;
+            if (senderLinks == 0 || _endMarkers < senderLinks || _received < _sentMsgs) return false;
+            if (_timedRunDone.exchange(true)) return false;
+            stopStats();
+            return true;
         }
 
-        void Receiver::on_error(const proton::error_condition &ec) {
-            std::cerr << "AmqpReceiver::on_error(): " << ec << std::endl;
+        void Receiver::startStats() {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            if (!_perfStats.isStarted()) {
+                _perfStats.start();
+            }
         }
 
-        // protected
+        void Receiver::stopStats() {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            if (!_perfStats.isStarted()) {
+                _perfStats.start(); // Nothing after the warmup was received
+            }
+            if (!_perfStats.isStopped()) {
+                _perfStats.stop();
+            }
+        }
 
         //static
         void Receiver::checkMessageType(const proton::value& val, proton::type_id amqpType) {
@@ -111,150 +247,112 @@ namespace qpidit
 
         //static
         std::string Receiver::getAmqpType(const proton::value& val) {
-            switch(val.type()) {
-                case proton::NULL_TYPE: return "null";
-                case proton::BOOLEAN: return "boolean";
-                case proton::UBYTE: return "ubyte";
-                case proton::USHORT: return "ushort";
-                case proton::UINT: return "uint";
-                case proton::ULONG: return "ulong";
-                case proton::BYTE: return "byte";
-                case proton::SHORT: return "short";
-                case proton::INT: return "int";
-                case proton::LONG: return "long";
-                case proton::FLOAT: return "float";
-                case proton::DOUBLE: return "double";
-                case proton::DECIMAL32: return "decimal32";
-                case proton::DECIMAL64: return "decimal64";
-                case proton::DECIMAL128: return "decimal128";
-                case proton::CHAR: return "char";
-                case proton::TIMESTAMP: return "timestamp";
-                case proton::UUID: return "uuid";
-                case proton::BINARY: return "binary";
-                case proton::STRING: return "string";
-                case proton::SYMBOL: return "symbol";
-                case proton::LIST: return "list";
-                case proton::MAP: return "map";
-                case proton::ARRAY: return "array";
-            }
-            return "unknown";
+            return AmqpTypes::typeName(val.type());
         }
 
-        //static
+        // The value is formatted into _valueBuffer, which is reused for every message
         Json::Value Receiver::getValue(const proton::value& val) {
-            return getValue(getAmqpType(val), val);
+            checkMessageType(val, _amqpTypeId);
+            _valueBuffer.clear();
+            appendValue(_valueBuffer, val);
+            return Json::Value(_valueBuffer.data(), _valueBuffer.data() + _valueBuffer.size());
         }
 
         //static
-        Json::Value Receiver::getValue(const std::string& amqpType, const proton::value& val) {
-            if (amqpType.compare("null") == 0) {
-                checkMessageType(val, proton::NULL_TYPE);
-                return "None";
-            }
-            if (amqpType.compare("boolean") == 0) {
-                checkMessageType(val, proton::BOOLEAN);
-                return proton::get<bool>(val) ? "True" : "False";
-            }
-            if (amqpType.compare("ubyte") == 0) {
-                checkMessageType(val, proton::UBYTE);
-                return toHexStr<uint8_t>(proton::get<uint8_t>(val));
-            }
-            if (amqpType.compare("ushort") == 0) {
-                checkMessageType(val, proton::USHORT);
-                return toHexStr<uint16_t>(proton::get<uint16_t>(val));
-            }
-            if (amqpType.compare("uint") == 0) {
-                checkMessageType(val, proton::UINT);
-                return toHexStr<uint32_t>(proton::get<uint32_t>(val));
-            }
-            if (amqpType.compare("ulong") == 0) {
-                checkMessageType(val, proton::ULONG);
-                return toHexStr<uint64_t>(proton::get<uint64_t>(val));
-            }
-            if (amqpType.compare("byte") == 0) {
-                checkMessageType(val, proton::BYTE);
-                return toHexStr<int8_t>(proton::get<int8_t>(val));
-            }
-            if (amqpType.compare("short") == 0) {
-                checkMessageType(val, proton::SHORT);
-                return toHexStr<int16_t>(proton::get<int16_t>(val));
-            }
-            if (amqpType.compare("int") == 0) {
-                checkMessageType(val, proton::INT);
-                return toHexStr<int32_t>(proton::get<int32_t>(val));
-            }
-            if (amqpType.compare("long") == 0) {
-                checkMessageType(val, proton::LONG);
-                return toHexStr<int64_t>(proton::get<int64_t>(val));
-            }
-            if (amqpType.compare("float") == 0) {
-                checkMessageType(val, proton::FLOAT);
-                float f = proton::get<float>(val);
-                return toHexStr<uint32_t>(*((uint32_t*)&f), true);
+        void Receiver::appendValue(std::string& out, const proton::value& val) {
+            switch (val.type()) {
+            case proton::NULL_TYPE:
+                out.append("None");
+                return;
+            case proton::BOOLEAN:
+                out.append(proton::get<bool>(val) ? "True" : "False");
+                return;
+            case proton::UBYTE: appendHexNumber(out, proton::get<uint8_t>(val)); return;
+            case proton::USHORT: appendHexNumber(out, proton::get<uint16_t>(val)); return;
+            case proton::UINT: appendHexNumber(out, proton::get<uint32_t>(val)); return;
+            case proton::ULONG: appendHexNumber(out, proton::get<uint64_t>(val)); return;
+            case proton::BYTE: appendHexNumber(out, proton::get<int8_t>(val)); return;
+            case proton::SHORT: appendHexNumber(out, proton::get<int16_t>(val)); return;
+            case proton::INT: appendHexNumber(out, proton::get<int32_t>(val)); return;
+            case proton::LONG: appendHexNumber(out, proton::get<int64_t>(val)); return;
+            case proton::FLOAT: {
+                const float f = proton::get<float>(val);
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                appendHexNumber(out, bits, true);
+                return;
             }
-            if (amqpType.compare("double") == 0) {
-                checkMessageType(val, proton::DOUBLE);
-                double d = proton::get<double>(val);
-                return toHexStr<uint64_t>(*((uint64_t*)&d), true);
+            case proton::DOUBLE: {
+                const double d = proton::get<double>(val);
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                appendHexNumber(out, bits, true);
+                return;
             }
-            if (amqpType.compare("decimal32") == 0) {
-                checkMessageType(val, proton::DECIMAL32);
-                return byteArrayToHexStr(proton::get<proton::decimal32>(val));
-            }
-            if (amqpType.compare("decimal64") == 0) {
-                checkMessageType(val, proton::DECIMAL64);
-                return byteArrayToHexStr(proton::get<proton::decimal64>(val));
-            }
-            if (amqpType.compare("decimal128") == 0) {
-                checkMessageType(val, proton::DECIMAL128);
-                return byteArrayToHexStr(proton::get<proton::decimal128>(val));
-            }
-            if (amqpType.compare("char") == 0) {
-                checkMessageType(val, proton::CHAR);
-                wchar_t c = proton::get<wchar_t>(val);
-                std::stringstream oss;
+            case proton::DECIMAL32: appendHexBytes(out, proton::get<proton::decimal32>(val)); return;
+            case proton::DECIMAL64: appendHexBytes(out, proton::get<proton::decimal64>(val)); return;
+            case proton::DECIMAL128: appendHexBytes(out, proton::get<proton::decimal128>(val)); return;
+            case proton::CHAR: {
+                const wchar_t c = proton::get<wchar_t>(val);
                 if (c < 0x7f && std::iswprint(c)) {
-                    oss << (char)c;
+                    out.push_back((char)c);
                 } else {
-                    oss << "0x" << std::hex << c;
+                    out.append("0x");
+                    appendHexDigits(out, uint32_t(c), 1);
                 }
-                return oss.str();
-            }
-            if (amqpType.compare("timestamp") == 0) {
-                checkMessageType(val, proton::TIMESTAMP);
-                std::ostringstream oss;
-                oss << "0x" << std::hex << proton::get<proton::timestamp>(val).milliseconds();
-                return oss.str();
+                return;
             }
-            if (amqpType.compare("uuid") == 0) {
-                checkMessageType(val, proton::UUID);
-                std::ostringstream oss;
-                oss << proton::get<proton::uuid>(val);
-                return oss.str();
+            case proton::TIMESTAMP:
+                out.append("0x");
+                appendHexDigits(out, uint64_t(proton::get<proton::timestamp>(val).milliseconds()), 1);
+                return;
+            case proton::UUID: {
+                // Format "00000000-0000-0000-0000-000000000000"
+                const proton::uuid u(proton::get<proton::uuid>(val));
+                static const size_t segmentEnds[] = {4, 6, 8, 10, 16};
+                size_t i = 0;
+                for (size_t s=0; s<sizeof(segmentEnds)/sizeof(segmentEnds[0]); ++s) {
+                    if (s > 0) out.push_back('-');
+                    for (; i<segmentEnds[s]; ++i) {
+                        appendHexDigits(out, uint8_t(u[i]), 2);
+                    }
+                }
+                return;
             }
-            if (amqpType.compare("binary") == 0) {
-                checkMessageType(val, proton::BINARY);
+            case proton::BINARY:
                 // Encode binary to base64 before returning value as string
-                return b64_encode(proton::get<proton::binary>(val));
-            }
-            if (amqpType.compare("string") == 0) {
-                checkMessageType(val, proton::STRING);
-                return proton::get<std::string>(val);
-            }
-            if (amqpType.compare("symbol") == 0) {
-                checkMessageType(val, proton::SYMBOL);
-                return proton::get<proton::symbol>(val);
+                b64_encode(proton::get<proton::binary>(val), out);
+                return;
+            case proton::STRING:
+                out.append(proton::get<std::string>(val));
+                return;
+            case proton::SYMBOL:
+                out.append(proton::get<proton::symbol>(val));
+                return;
+            case proton::LIST:
+            case proton::MAP:
+            case proton::ARRAY:
+                throw qpidit::UnsupportedAmqpTypeError(getAmqpType(val));
+            default:
+                throw qpidit::UnknownAmqpTypeError(getAmqpType(val));
             }
-            if (amqpType.compare("list") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
-            }
-            if (amqpType.compare("map") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
-            }
-            if (amqpType.compare("array") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
+        }
+
+        //static
+        // Appends the hex digits of val, zero-filled to at least minDigits
+        void Receiver::appendHexDigits(std::string& out, uint64_t val, size_t minDigits) {
+            static const char hexDigits[] = "0123456789abcdef";
+            char digits[16];
+            char* const end = digits + sizeof(digits);
+            char* p = end;
+            do {
+                *--p = hexDigits[val & 0xf];
+                val >>= 4;
+            } while (val != 0);
+            if (size_t(end - p) < minDigits) {
+                out.append(minDigits - (end - p), '0');
             }
-            throw qpidit::UnknownAmqpTypeError(amqpType);
+            out.append(p, end);
         }
 
     } /* namespace amqp_types_test */
@@ -267,25 +365,51 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: Expected number of test values to receive
+ *       5+: Options (optional):
+ *           --repeat N: Expect each test value N times
+ *           --duration S: Receive until the end marker of each sender link and the messages sent before them
+ *                         have arrived (the sender times the run)
+ *           --warmup N: Expect N additional messages before starting measurement
+ *           --latency: Record one-way latency from the send time stamped by a sender run with --latency,
+ *                      reported as percentiles in the stats
+ *           --connections C: Open C connections (default 1)
+ *           --links-per-connection L: Open L receiver links on each connection, benchmark mode only (default 1)
+ *           --threads T: Run the container with T threads (default 1)
+ *           --credit-window N: Issue N credits on each link (default: the proton default window)
+ *           --credit-low-water M: Manage credit manually, topping it back up to N once it falls to M
+ *           --ack-batch B: Accept deliveries B at a time (default 1)
+ *           --stream: Write each received value as a line of JSON as it arrives (NDJSON), after the AMQP type
+ *                     line, followed by a summary line in place of the received value list
+ *       Any of --repeat, --duration, --warmup or --latency selects benchmark mode, which prints throughput stats
+ *       as JSON in place of the received value list
  */
 
 int main(int argc, char** argv) {
     try {
         // TODO: improve arg management a little...
-        if (argc != 5) {
+        if (argc < 5) {
             throw qpidit::ArgumentError("Incorrect number of arguments");
         }
+        const qpidit::ShimOptions options(argc, argv, 5);
 
-        qpidit::amqp_types_test::Receiver receiver(argv[1], argv[2], argv[3], std::strtoul(argv[4], NULL, 0));
-        proton::container(receiver).run();
+        qpidit::amqp_types_test::Receiver receiver(argv[1], argv[2], argv[3], std::strtoul(argv[4], NULL, 0), options);
+        options.checkAllUsed();
+        if (receiver.isStreaming()) {
+            // Values are written while receiving, so the AMQP type line goes first
+            std::cout << argv[3] << std::endl;
+            proton::container(receiver).run(receiver.getNumThreads());
+            receiver.writeStreamSummary();
+        } else {
+            proton::container(receiver).run(receiver.getNumThreads());
 
-        std::cout << argv[3] << std::endl;
-        Json::StreamWriterBuilder wbuilder;
-        wbuilder["indentation"] = "";
-        std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
-        std::ostringstream oss;
-        writer->write(receiver.getReceivedValueList(), &oss);
-        std::cout << oss.str() << std::endl;
+            std::cout << argv[3] << std::endl;
+            Json::StreamWriterBuilder wbuilder;
+            wbuilder["indentation"] = "";
+            std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
+            std::ostringstream oss;
+            writer->write(receiver.isBenchmark() ? receiver.getStats() : receiver.getReceivedValueList(), &oss);
+            std::cout << oss.str() << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "AmqpReceiver error: " << e.what() << std::endl;
         exit(-1);
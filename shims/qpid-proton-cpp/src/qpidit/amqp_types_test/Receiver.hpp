@@ -22,61 +22,101 @@
 #ifndef SRC_QPIDIT_AMQP_TYPES_TEST_RECEIVER_HPP_
 #define SRC_QPIDIT_AMQP_TYPES_TEST_RECEIVER_HPP_
 
-#include <iomanip>
+#include <atomic>
 #include <json/value.h>
-#include <proton/messaging_handler.hpp>
+#include <memory>
+#include <mutex>
 #include <proton/types.hpp>
-#include <sstream>
+#include <qpidit/AlignedAllocator.hpp>
+#include <qpidit/AmqpReceiverBase.hpp>
+#include <qpidit/LatencyHistogram.hpp>
+#include <qpidit/NdjsonWriter.hpp>
+#include <qpidit/PerfStats.hpp>
+#include <qpidit/ShimOptions.hpp>
+#include <type_traits>
+#include <vector>
 
 namespace qpidit
 {
     namespace amqp_types_test
     {
 
-        class Receiver : public proton::messaging_handler
+        class Receiver : public qpidit::AmqpReceiverBase
         {
         protected:
-            const std::string _brokerUrl;
-            const std::string _queueName;
+            // Benchmark counts of one link, only accessed from its connection's handler thread,
+            // merged into the stats once the run is complete
+            struct alignas(64) LinkStats
+            {
+                uint64_t msgCount;
+                uint64_t byteCount;
+                uint64_t unstampedCount; // Messages without a send time, which --latency cannot record
+                LatencyHistogram latencyHistogram;
+                LinkStats();
+            };
+            typedef std::vector<LinkStats, AlignedAllocator<LinkStats> > LinkStatsList_t;
+
             const std::string _amqpType;
+            const proton::type_id _amqpTypeId; // _amqpType resolved once
+            std::string _valueBuffer;          // Reused to format each received value
             uint32_t _expected;
-            uint32_t _received;
+            std::atomic<uint32_t> _received;
             Json::Value _receivedValueList;
+            const uint32_t _warmupMsgs;   // --warmup N: messages received before measurement starts
+            const bool _untilEndMarker;   // --duration: receive until the end markers of all the sender's links
+            std::atomic<uint32_t> _endMarkers;  // End markers received
+            std::atomic<uint32_t> _senderLinks; // Sender links, each sending one end marker, 0 until the first arrives
+            std::atomic<uint64_t> _sentMsgs;    // Messages sent before the end markers received, summed over them
+            std::atomic<bool> _timedRunDone;
+            const bool _latencyFlag;      // --latency: record one-way latency from the sender's send time
+            const bool _benchmarkFlag;
+            std::mutex _statsMutex;       // Held to start and stop _perfStats
+            PerfStats _perfStats;
+            LinkStatsList_t _linkStats;
+            std::unique_ptr<NdjsonWriter> _ndjsonWriter; // --stream: write each received value as it arrives
         public:
-            Receiver(const std::string& brokerUrl, const std::string& queueName, const std::string& amqpType, uint32_t exptected);
+            Receiver(const std::string& brokerAddr,
+                     const std::string& queueName,
+                     const std::string& amqpType,
+                     uint32_t exptected,
+                     const qpidit::ShimOptions& options);
             virtual ~Receiver();
             Json::Value& getReceivedValueList();
-            void on_container_start(proton::container &c);
+            bool isBenchmark() const;
+            Json::Value getStats() const;
+            bool isStreaming() const;
+            void writeStreamSummary();
             void on_message(proton::delivery &d, proton::message &m);
-
-            void on_connection_error(proton::connection &c);
-            void on_receiver_error(proton::receiver& r);
-            void on_session_error(proton::session &s);
-            void on_transport_error(proton::transport &t);
-            void on_error(const proton::error_condition &c);
         protected:
+            bool measureMessage(proton::delivery& d, proton::message& m);
+            void addEndMarker(const proton::message& m);
+            bool isTimedRunDone();
+            void startStats();
+            void stopStats();
+
             static void checkMessageType(const proton::value& val, const proton::type_id amqpType);
             static std::string getAmqpType(const proton::value& val);
-            static Json::Value getValue(const proton::value& val);
-            static Json::Value getValue(const std::string& amqpType, const proton::value& val);
+            Json::Value getValue(const proton::value& val);
+            static void appendValue(std::string& out, const proton::value& val);
+            static void appendHexDigits(std::string& out, uint64_t val, size_t minDigits);
 
             // Format signed numbers in negative hex format, ie -0xNNNN, positive numbers in 0xNNNN format
-            template<typename T> static std::string toHexStr(T val, bool fillFlag = false) {
-                std::ostringstream oss;
-                bool neg = val < 0;
-                if (neg) val = -val;
-                oss << (neg ? "-" : "") << "0x" << std::hex;
-                if (fillFlag) {
-                    oss << std::setw(sizeof(T)*2) << std::setfill('0');
+            template<typename T> static void appendHexNumber(std::string& out, T val, bool fillFlag = false) {
+                typedef typename std::make_unsigned<T>::type U;
+                U magnitude(val);
+                if (val < 0) {
+                    out.push_back('-');
+                    magnitude = U(U(0) - magnitude);
                 }
-                oss << (sizeof(T) == 1 ? (int)val & 0xff : sizeof(T) == 2 ? val & 0xffff : /*sizeof(T) == 4 ? val & 0xffffffff :*/ val);
-                return oss.str();
+                out.append("0x");
+                appendHexDigits(out, magnitude, fillFlag ? sizeof(T)*2 : 1);
             }
 
-            template<size_t N> static std::string byteArrayToHexStr(const proton::byte_array<N>& val) {
-                std::ostringstream oss;
-                oss << val;
-                return oss.str();
+            template<size_t N> static void appendHexBytes(std::string& out, const proton::byte_array<N>& val) {
+                out.append("0x");
+                for (size_t i=0; i<N; ++i) {
+                    appendHexDigits(out, uint8_t(val[i]), 2);
+                }
             }
         };
 
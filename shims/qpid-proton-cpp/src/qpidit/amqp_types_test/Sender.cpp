@@ -31,6 +31,9 @@
 #include <proton/container.hpp>
 #include <proton/sender.hpp>
 #include <proton/tracker.hpp>
+#include <qpidit/AllocTracker.hpp>
+#include <qpidit/AmqpTypes.hpp>
+#include <qpidit/PnData.hpp>
 
 namespace qpidit
 {
@@ -40,161 +43,240 @@ namespace qpidit
         Sender::Sender(const std::string& brokerAddr,
                        const std::string& queueName,
                        const std::string& amqpType,
-                       const Json::Value& testValues) :
-                        AmqpSenderBase("amqp_types_test::Sender", brokerAddr, queueName, testValues.size()),
+                       const Json::Value& testValues,
+                       const qpidit::ShimOptions& options) :
+                        AmqpSenderBase("amqp_types_test::Sender", brokerAddr, queueName,
+                                       getTotalNumMessages(testValues.size(), options), options),
                         _amqpType(amqpType),
-                        _testValues(testValues)
-        {}
+                        _testValues(testValues),
+                        _amqpValues(),
+                        _warmupMsgs(options.getUInt("warmup", 0)),
+                        _durationSecs(options.getDouble("duration", 0.0)),
+                        _benchmarkFlag(options.hasOption("repeat") || options.hasOption("duration") || options.hasOption("warmup")),
+                        _statsMutex(),
+                        _perfStats()
+        {
+            const Converter_t converter = getConverter(AmqpTypes::typeId(_amqpType));
+            for (Json::Value::const_iterator i=_testValues.begin(); i!=_testValues.end(); ++i) {
+                _amqpValues.push_back(converter(_amqpType, *i));
+            }
+            _endMarkers = _durationSecs > 0.0;
+        }
 
         Sender::~Sender() {}
 
+        bool Sender::isBenchmark() const {
+            return _benchmarkFlag;
+        }
+
+        Json::Value Sender::getStats() const {
+            Json::Value stats(_perfStats.toJson());
+            if (AllocTracker::isEnabled()) {
+                stats["alloc"] = AllocTracker::toJson();
+            }
+            return stats;
+        }
+
         void Sender::on_sendable(proton::sender &s) {
-            if (_totalMsgs == 0) {
-                s.connection().close();
-            } else if (_msgsSent == 0) {
-                for (Json::Value::const_iterator i=_testValues.begin(); i!=_testValues.end(); ++i) {
-                    if (s.credit()) {
-                        proton::message msg;
-                        s.send(setMessage(msg, *i));
-                        _msgsSent++;
-                    }
+            if (_benchmarkFlag) {
+                std::lock_guard<std::mutex> lock(_statsMutex);
+                // In a timed run, the send cursor ends at the messages already claimed once the duration expires,
+                // after which each link sends its end marker
+                if (_durationSecs > 0.0 && _msgsSent < _totalMsgs && _perfStats.isStarted() &&
+                    _perfStats.elapsedSeconds() >= _durationSecs) {
+                    std::lock_guard<std::mutex> cursorLock(_sendCursorMutex);
+                    _totalMsgs = _msgsSent.load();
                 }
-            } else {
-                // do nothing
             }
+            AmqpSenderBase::on_sendable(s);
+            stopStatsOnCompletion();
+        }
+
+        void Sender::on_tracker_accept(proton::tracker &t) {
+            AmqpSenderBase::on_tracker_accept(t);
+            stopStatsOnCompletion();
         }
 
         // protected
 
-        proton::message& Sender::setMessage(proton::message& msg, const Json::Value& testValue) {
-            msg.id(_msgsSent + 1);
-            msg.body(convertAmqpValue(_amqpType, testValue));
+        proton::message& Sender::setMessage(proton::message& msg, uint32_t msgNum) {
+            msg.id(msgNum + 1);
+            msg.body(_amqpValues[getContentKey(msgNum)]);
             return msg;
         }
 
-        //static
-        proton::value Sender::convertAmqpValue(const std::string& amqpType, const Json::Value& testValue) {
-            if (amqpType.compare("null") == 0) {
-                std::string testValueStr(testValue.asString());
-                if (testValueStr.compare("None") != 0) {
-                    throw qpidit::InvalidTestValueError(amqpType, testValueStr);
+        uint32_t Sender::getContentKey(uint32_t msgNum) const {
+            return msgNum % _amqpValues.size();
+        }
+
+        // Measurement starts as message _warmupMsgs, the first one counted by stopStatsOnCompletion(), is sent
+        void Sender::beforeSend(uint32_t msgNum) {
+            if (_benchmarkFlag && msgNum == _warmupMsgs) {
+                std::lock_guard<std::mutex> lock(_statsMutex);
+                if (!_perfStats.isStarted()) { // Not restarted when a reconnect resends it
+                    _perfStats.start();
                 }
-                proton::value v;
-                return v;
             }
-            if (amqpType.compare("boolean") == 0) {
-                std::string testValueStr(testValue.asString());
-                if (testValueStr.compare("True") == 0) {
-                    return true;
-                } else if (testValueStr.compare("False") == 0) {
-                    return false;
-                } else {
-                    throw qpidit::InvalidTestValueError(amqpType, testValueStr);
+        }
+
+        void Sender::stopStatsOnCompletion() {
+            if (!_benchmarkFlag || !isComplete()) return;
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            if (!_perfStats.isStopped()) {
+                _perfStats.stop();
+                std::vector<size_t> encodedSizes;
+                for (std::vector<proton::value>::const_iterator i=_amqpValues.begin(); i!=_amqpValues.end(); ++i) {
+                    encodedSizes.push_back(PnData::encodedSize(*i));
                 }
-            }
-            if (amqpType.compare("ubyte") == 0) {
-                return integralValue<uint8_t>(amqpType, testValue.asString(), true);
-            }
-            if (amqpType.compare("ushort") == 0) {
-                return integralValue<uint16_t>(amqpType, testValue.asString(), true);
-            }
-            if (amqpType.compare("uint") == 0) {
-                return integralValue<uint32_t>(amqpType, testValue.asString(), true);
-            }
-            if (amqpType.compare("ulong") == 0) {
-                return integralValue<uint64_t>(amqpType, testValue.asString(), true);
-            }
-            if (amqpType.compare("byte") == 0) {
-                return integralValue<int8_t>(amqpType, testValue.asString(), false);
-            }
-            if (amqpType.compare("short") == 0) {
-                return integralValue<int16_t>(amqpType, testValue.asString(), false);
-            }
-            if (amqpType.compare("int") == 0) {
-                return integralValue<int32_t>(amqpType, testValue.asString(), false);
-            }
-            if (amqpType.compare("long") == 0) {
-                return integralValue<int64_t>(amqpType, testValue.asString(), false);
-            }
-            if (amqpType.compare("float") == 0) {
-                const std::string testValueStr = testValue.asString();
-                if (testValueStr.find("0x") == std::string::npos) // regular decimal fraction
-                    return std::strtof(testValueStr.c_str(), NULL);
-                // hex representation of float
-                return floatValue<float, uint32_t>(amqpType, testValue.asString());
-            }
-            if (amqpType.compare("double") == 0) {
-                const std::string testValueStr = testValue.asString();
-                if (testValueStr.find("0x") == std::string::npos) // regular decimal fraction
-                    return std::strtod(testValueStr.c_str(), NULL);
-                // hex representation of float
-                return floatValue<double, uint64_t>(amqpType, testValue.asString());
-            }
-            if (amqpType.compare("decimal32") == 0) {
-                proton::decimal32 val;
-                hexStringToBytearray(val, testValue.asString().substr(2));
-                return val;
-            }
-            if (amqpType.compare("decimal64") == 0) {
-                proton::decimal64 val;
-                hexStringToBytearray(val, testValue.asString().substr(2));
-                return val;
-            }
-            if (amqpType.compare("decimal128") == 0) {
-                proton::decimal128 val;
-                hexStringToBytearray(val, testValue.asString().substr(2));
-                return val;
-            }
-            if (amqpType.compare("char") == 0) {
-                std::string charStr = testValue.asString();
-                wchar_t val;
-                if (charStr.size() == 1) { // Single char "a"
-                    val = charStr[0];
-                } else if (charStr.size() >= 3 && charStr.size() <= 10) { // Format "0xN" through "0xNNNNNNNN"
-                    val = std::strtoul(charStr.data(), NULL, 16);
-                } else {
-                    //TODO throw format error
+                for (uint32_t msgNum=_warmupMsgs; msgNum<_totalMsgs; ++msgNum) {
+                    _perfStats.add(1, encodedSizes[getContentKey(msgNum)]);
                 }
-                return val;
-            }
-            if (amqpType.compare("timestamp") == 0) {
-                const std::string testValueStr(testValue.asString());
-                bool xhexFlag = testValueStr.find("0x") != std::string::npos;
-                return proton::timestamp(std::strtoul(testValue.asString().data(), NULL, xhexFlag ? 16 : 10));
             }
-            if (amqpType.compare("uuid") == 0) {
-                proton::uuid val;
-                std::string uuidStr(testValue.asString());
-                // Expected format: "00000000-0000-0000-0000-000000000000"
-                //                   ^        ^    ^    ^    ^
-                //    start index -> 0        9    14   19   24
-                hexStringToBytearray(val, uuidStr.substr(0, 8), 0, 4);
-                hexStringToBytearray(val, uuidStr.substr(9, 4), 4, 2);
-                hexStringToBytearray(val, uuidStr.substr(14, 4), 6, 2);
-                hexStringToBytearray(val, uuidStr.substr(19, 4), 8, 2);
-                hexStringToBytearray(val, uuidStr.substr(24, 12), 10, 6);
-                return val;
-            }
-            if (amqpType.compare("binary") == 0) {
-                // Base64 decode to binary string
-                return b64_decode(testValue.asString());
+        }
+
+        //static
+        uint32_t Sender::getTotalNumMessages(uint32_t numTestValues, const qpidit::ShimOptions& options) {
+            if (numTestValues == 0) return 0;
+            if (options.getDouble("duration", 0.0) > 0.0) {
+                return UINT32_MAX; // Until the duration expires
             }
-            if (amqpType.compare("string") == 0) {
-                return std::string(testValue.asString());
+            const uint64_t totalMsgs = options.getUInt("warmup", 0) + options.getUInt("repeat", 1) * numTestValues;
+            if (totalMsgs >= UINT32_MAX) {
+                throw qpidit::ArgumentError(MSG("Too many messages requested: " << totalMsgs));
             }
-            if (amqpType.compare("symbol") == 0) {
-                return proton::symbol(testValue.asString());
+            return totalMsgs;
+        }
+
+        //static
+        // The type is resolved once, each test value is then converted by a direct call
+        Sender::Converter_t Sender::getConverter(proton::type_id amqpTypeId) {
+            struct ConverterEntry
+            {
+                proton::type_id typeId;
+                Converter_t converter;
+            };
+            static constexpr ConverterEntry converterTable[] = {
+                {proton::NULL_TYPE, nullValue},
+                {proton::BOOLEAN, booleanValue},
+                {proton::UBYTE, integralConverter<uint8_t, true>},
+                {proton::USHORT, integralConverter<uint16_t, true>},
+                {proton::UINT, integralConverter<uint32_t, true>},
+                {proton::ULONG, integralConverter<uint64_t, true>},
+                {proton::BYTE, integralConverter<int8_t, false>},
+                {proton::SHORT, integralConverter<int16_t, false>},
+                {proton::INT, integralConverter<int32_t, false>},
+                {proton::LONG, integralConverter<int64_t, false>},
+                {proton::FLOAT, floatConverter},
+                {proton::DOUBLE, doubleConverter},
+                {proton::DECIMAL32, decimalConverter<proton::decimal32>},
+                {proton::DECIMAL64, decimalConverter<proton::decimal64>},
+                {proton::DECIMAL128, decimalConverter<proton::decimal128>},
+                {proton::CHAR, charValue},
+                {proton::TIMESTAMP, timestampValue},
+                {proton::UUID, uuidValue},
+                {proton::BINARY, binaryValue},
+                {proton::STRING, stringValue},
+                {proton::SYMBOL, symbolValue}
+            };
+            for (size_t i=0; i<sizeof(converterTable)/sizeof(converterTable[0]); ++i) {
+                if (converterTable[i].typeId == amqpTypeId) {
+                    return converterTable[i].converter;
+                }
             }
-            if (amqpType.compare("list") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
+            // list, map and array
+            throw qpidit::UnsupportedAmqpTypeError(AmqpTypes::typeName(amqpTypeId));
+        }
+
+        //static
+        proton::value Sender::nullValue(const std::string& amqpType, const Json::Value& testValue) {
+            std::string testValueStr(testValue.asString());
+            if (testValueStr.compare("None") != 0) {
+                throw qpidit::InvalidTestValueError(amqpType, testValueStr);
             }
-            if (amqpType.compare("map") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
+            proton::value v;
+            return v;
+        }
+
+        //static
+        proton::value Sender::booleanValue(const std::string& amqpType, const Json::Value& testValue) {
+            std::string testValueStr(testValue.asString());
+            if (testValueStr.compare("True") == 0) {
+                return true;
+            } else if (testValueStr.compare("False") == 0) {
+                return false;
+            } else {
+                throw qpidit::InvalidTestValueError(amqpType, testValueStr);
             }
-            if (amqpType.compare("array") == 0) {
-                throw qpidit::UnsupportedAmqpTypeError(amqpType);
+        }
+
+        //static
+        proton::value Sender::floatConverter(const std::string& amqpType, const Json::Value& testValue) {
+            const std::string testValueStr = testValue.asString();
+            if (testValueStr.find("0x") == std::string::npos) // regular decimal fraction
+                return std::strtof(testValueStr.c_str(), NULL);
+            // hex representation of float
+            return floatValue<float, uint32_t>(amqpType, testValueStr);
+        }
+
+        //static
+        proton::value Sender::doubleConverter(const std::string& amqpType, const Json::Value& testValue) {
+            const std::string testValueStr = testValue.asString();
+            if (testValueStr.find("0x") == std::string::npos) // regular decimal fraction
+                return std::strtod(testValueStr.c_str(), NULL);
+            // hex representation of double
+            return floatValue<double, uint64_t>(amqpType, testValueStr);
+        }
+
+        //static
+        proton::value Sender::charValue(const std::string& amqpType, const Json::Value& testValue) {
+            std::string charStr = testValue.asString();
+            wchar_t val;
+            if (charStr.size() == 1) { // Single char "a"
+                val = charStr[0];
+            } else if (charStr.size() >= 3 && charStr.size() <= 10) { // Format "0xN" through "0xNNNNNNNN"
+                val = std::strtoul(charStr.data(), NULL, 16);
+            } else {
+                //TODO throw format error
             }
-            throw qpidit::UnknownAmqpTypeError(amqpType);
+            return val;
+        }
+
+        //static
+        proton::value Sender::timestampValue(const std::string& amqpType, const Json::Value& testValue) {
+            const std::string testValueStr(testValue.asString());
+            bool xhexFlag = testValueStr.find("0x") != std::string::npos;
+            return proton::timestamp(std::strtoul(testValueStr.data(), NULL, xhexFlag ? 16 : 10));
+        }
+
+        //static
+        proton::value Sender::uuidValue(const std::string& amqpType, const Json::Value& testValue) {
+            proton::uuid val;
+            std::string uuidStr(testValue.asString());
+            // Expected format: "00000000-0000-0000-0000-000000000000"
+            //                   ^        ^    ^    ^    ^
+            //    start index -> 0        9    14   19   24
+            hexStringToBytearray(val, uuidStr.substr(0, 8), 0, 4);
+            hexStringToBytearray(val, uuidStr.substr(9, 4), 4, 2);
+            hexStringToBytearray(val, uuidStr.substr(14, 4), 6, 2);
+            hexStringToBytearray(val, uuidStr.substr(19, 4), 8, 2);
+            hexStringToBytearray(val, uuidStr.substr(24, 12), 10, 6);
+            return val;
+        }
+
+        //static
+        proton::value Sender::binaryValue(const std::string& amqpType, const Json::Value& testValue) {
+            // Base64 decode to binary string
+            return b64_decode(testValue.asString());
+        }
+
+        //static
+        proton::value Sender::stringValue(const std::string& amqpType, const Json::Value& testValue) {
+            return std::string(testValue.asString());
+        }
+
+        //static
+        proton::value Sender::symbolValue(const std::string& amqpType, const Json::Value& testValue) {
+            return proton::symbol(testValue.asString());
         }
 
     } /* namespace amqp_types_test */
@@ -207,14 +289,26 @@ namespace qpidit
  *       2: Queue name
  *       3: AMQP type
  *       4: Test value(s) as JSON string
+ *       5+: Options (optional):
+ *           --pre-encoded: Encode each test value once, then send the encoded bytes with a patched message-id
+ *           --latency: Stamp each message with its send time for a receiver run with --latency
+ *           --delivery-mode at-least-once|at-most-once: at-most-once sends pre-settled messages (default at-least-once)
+ *           --repeat N: Cycle through the test values N times
+ *           --duration S: Cycle through the test values for S seconds, then send an end marker message on each link
+ *           --warmup N: Send N messages before starting measurement
+ *           --connections C: Open C connections (default 1)
+ *           --links-per-connection L: Open L sender links on each connection, which share the send cursor (default 1)
+ *           --threads T: Run the container with T threads (default 1)
+ *       Any of --repeat, --duration or --warmup selects benchmark mode, which prints throughput stats as JSON
  */
 
 int main(int argc, char** argv) {
     try {
         // TODO: improve arg management a little...
-        if (argc != 5) {
+        if (argc < 5) {
             throw qpidit::ArgumentError("Incorrect number of arguments");
         }
+        const qpidit::ShimOptions options(argc, argv, 5);
 
         Json::Value testValues;
         Json::CharReaderBuilder rbuilder;
@@ -224,8 +318,18 @@ int main(int argc, char** argv) {
             throw qpidit::JsonParserError(parseErrors);
         }
 
-        qpidit::amqp_types_test::Sender sender(argv[1], argv[2], argv[3], testValues);
-        proton::container(sender).run();
+        qpidit::amqp_types_test::Sender sender(argv[1], argv[2], argv[3], testValues, options);
+        options.checkAllUsed();
+        proton::container(sender).run(sender.getNumThreads());
+
+        if (sender.isBenchmark()) {
+            Json::StreamWriterBuilder wbuilder;
+            wbuilder["indentation"] = "";
+            std::unique_ptr<Json::StreamWriter> writer(wbuilder.newStreamWriter());
+            std::ostringstream oss;
+            writer->write(sender.getStats(), &oss);
+            std::cout << oss.str() << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "amqp_types_test Sender error: " << e.what() << std::endl;
         exit(1);
@@ -25,7 +25,11 @@
 #include <json/value.h>
 #include <proton/message.hpp>
 #include <qpidit/AmqpSenderBase.hpp>
+#include <qpidit/PerfStats.hpp>
 #include <qpidit/QpidItErrors.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace qpidit
 {
@@ -37,17 +41,59 @@ namespace qpidit
         protected:
             const std::string _amqpType;
             const Json::Value _testValues;
+            std::vector<proton::value> _amqpValues; // _testValues converted once, cycled by the send cursor
+            const uint32_t _warmupMsgs;   // --warmup N: messages sent before measurement starts
+            const double _durationSecs;   // --duration S: send for S seconds, then an end marker on each link
+            const bool _benchmarkFlag;
+            std::mutex _statsMutex;
+            PerfStats _perfStats;
 
         public:
-            Sender(const std::string& brokerAddr, const std::string& queueName, const std::string& amqpType, const Json::Value& testValues);
+            Sender(const std::string& brokerAddr,
+                   const std::string& queueName,
+                   const std::string& amqpType,
+                   const Json::Value& testValues,
+                   const qpidit::ShimOptions& options);
             virtual ~Sender();
 
+            bool isBenchmark() const;
+            Json::Value getStats() const;
+
             void on_sendable(proton::sender &s);
+            void on_tracker_accept(proton::tracker &t);
 
         protected:
-            proton::message& setMessage(proton::message& msg, const Json::Value& testValue);
+            proton::message& setMessage(proton::message& msg, uint32_t msgNum);
+            uint32_t getContentKey(uint32_t msgNum) const;
+            void beforeSend(uint32_t msgNum);
+            void stopStatsOnCompletion();
+
+            static uint32_t getTotalNumMessages(uint32_t numTestValues, const qpidit::ShimOptions& options);
+
+            // Converts a JSON test value to a value of one AMQP type, amqpType is the type name for error messages
+            typedef proton::value (*Converter_t)(const std::string& amqpType, const Json::Value& testValue);
+            static Converter_t getConverter(proton::type_id amqpTypeId);
+
+            static proton::value nullValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value booleanValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value floatConverter(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value doubleConverter(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value charValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value timestampValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value uuidValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value binaryValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value stringValue(const std::string& amqpType, const Json::Value& testValue);
+            static proton::value symbolValue(const std::string& amqpType, const Json::Value& testValue);
 
-            static proton::value convertAmqpValue(const std::string& amqpType, const Json::Value& testValue);
+            template<typename T, bool UnsignedVal> static proton::value integralConverter(const std::string& amqpType, const Json::Value& testValue) {
+                return integralValue<T>(amqpType, testValue.asString(), UnsignedVal);
+            }
+
+            template<typename T> static proton::value decimalConverter(const std::string& amqpType, const Json::Value& testValue) {
+                T val;
+                hexStringToBytearray(val, testValue.asString().substr(2));
+                return val;
+            }
 
             template<size_t N> static void hexStringToBytearray(proton::byte_array<N>& ba, const std::string s, size_t fromArrayIndex = 0, size_t arrayLen = N) {
                 for (size_t i=0; i<arrayLen; ++i) {
@@ -32,6 +32,7 @@
 #include <proton/message.hpp>
 #include <proton/thread_safe.hpp>
 #include <proton/transport.hpp>
+#include <qpidit/AllocTracker.hpp>
 #include <qpidit/QpidItErrors.hpp>
 
 namespace qpidit
@@ -73,6 +74,7 @@ namespace qpidit
         }
 
         void Receiver::on_container_start(proton::container &c) {
+            qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::CONNECT);
             std::ostringstream oss;
             oss << _brokerUrl << "/" << _queueName;
             c.open_receiver(oss.str());
@@ -81,6 +83,7 @@ namespace qpidit
         void Receiver::on_message(proton::delivery &d, proton::message &m) {
             try {
                 if (_received < _expected) {
+                    qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::TRANSFER);
                     int8_t t = qpidit::JMS_MESSAGE_TYPE; // qpidit::JMS_MESSAGE_TYPE has value 0
                     try {
                         t = proton::get<int8_t>(m.message_annotations().get(proton::symbol("x-opt-jms-msg-type")));
@@ -127,6 +130,7 @@ namespace qpidit
                     }
                     _received++;
                     if (_received >= _expected) {
+                        qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::SHUTDOWN);
                         d.receiver().close();
                         d.connection().close();
                     }
@@ -32,6 +32,7 @@
 #include <proton/thread_safe.hpp>
 #include <proton/tracker.hpp>
 #include <proton/transport.hpp>
+#include <qpidit/AllocTracker.hpp>
 #include <stdio.h>
 
 namespace qpidit
@@ -53,22 +54,27 @@ namespace qpidit
             if (_testValueMap.type() != Json::objectValue) {
                 throw qpidit::InvalidJsonRootNodeError(Json::objectValue, _testValueMap.type());
             }
+            _subTypes = _testValueMap.getMemberNames();
+            std::sort(_subTypes.begin(), _subTypes.end());
         }
 
         Sender::~Sender() {}
 
         void Sender::on_container_start(proton::container &c) {
+            qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::CONNECT);
             c.open_sender(_brokerUrl);
         }
 
         void Sender::on_sendable(proton::sender &s) {
             if (_totalMsgs == 0) {
+                qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::SHUTDOWN);
                 s.connection().close();
-            } else if (_msgsSent == 0) {
-                Json::Value::Members subTypes = _testValueMap.getMemberNames();
-                std::sort(subTypes.begin(), subTypes.end());
-                for (std::vector<std::string>::const_iterator i=subTypes.begin(); i!=subTypes.end(); ++i) {
-                    sendMessages(s, *i, _testValueMap[*i]);
+            } else {
+                qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::TRANSFER);
+                // Resume from the send cursor each time credit is issued until all messages are sent
+                while (s.credit() > 0 && _msgsSent < _totalMsgs) {
+                    sendMessage(s, _msgsSent);
+                    _msgsSent += 1;
                 }
             }
         }
@@ -76,6 +82,7 @@ namespace qpidit
         void Sender::on_tracker_accept(proton::tracker &t) {
             _msgsConfirmed++;
             if (_msgsConfirmed == _totalMsgs) {
+                qpidit::AllocTracker::advancePhase(qpidit::AllocTracker::SHUTDOWN);
                 t.connection().close();
             }
         }
@@ -86,34 +93,35 @@ namespace qpidit
 
         // protected
 
-        void Sender::sendMessages(proton::sender &s, const std::string& subType, const Json::Value& testValues) {
-            uint32_t valueNumber = 0;
-            for (Json::Value::const_iterator i=testValues.begin(); i!=testValues.end(); ++i) {
-                if (s.credit()) {
-                    proton::message msg;
-                    if (_jmsMessageType.compare("JMS_MESSAGE_TYPE") == 0) {
-                        setMessage(msg, subType, (*i).asString());
-                    } else if (_jmsMessageType.compare("JMS_BYTESMESSAGE_TYPE") == 0) {
-                        setBytesMessage(msg, subType, (*i).asString());
-                    } else if (_jmsMessageType.compare("JMS_MAPMESSAGE_TYPE") == 0) {
-                        setMapMessage(msg, subType, (*i).asString(), valueNumber);
-                    } else if (_jmsMessageType.compare("JMS_OBJECTMESSAGE_TYPE") == 0) {
-                        setObjectMessage(msg, subType, *i);
-                    } else if (_jmsMessageType.compare("JMS_STREAMMESSAGE_TYPE") == 0) {
-                        setStreamMessage(msg, subType, (*i).asString());
-                    } else if (_jmsMessageType.compare("JMS_TEXTMESSAGE_TYPE") == 0) {
-                        setTextMessage(msg, *i);
-                    } else {
-                        throw qpidit::UnknownJmsMessageTypeError(_jmsMessageType);
-                    }
-                    addMessageHeaders(msg);
-                    addMessageProperties(msg);
-                    s.send(msg);
-                    _msgsSent += 1;
-                    valueNumber += 1;
-                }
+        void Sender::sendMessage(proton::sender &s, uint32_t msgNum) {
+            // Locate sub-type and value number of message msgNum in sorted sub-type order
+            Json::Value::Members::const_iterator subType = _subTypes.begin();
+            uint32_t valueNumber = msgNum;
+            while (valueNumber >= _testValueMap[*subType].size()) {
+                valueNumber -= _testValueMap[*subType].size();
+                ++subType;
             }
-
+            const Json::Value& testValue = _testValueMap[*subType][valueNumber];
+
+            proton::message msg;
+            if (_jmsMessageType.compare("JMS_MESSAGE_TYPE") == 0) {
+                setMessage(msg, *subType, testValue.asString());
+            } else if (_jmsMessageType.compare("JMS_BYTESMESSAGE_TYPE") == 0) {
+                setBytesMessage(msg, *subType, testValue.asString());
+            } else if (_jmsMessageType.compare("JMS_MAPMESSAGE_TYPE") == 0) {
+                setMapMessage(msg, *subType, testValue.asString(), valueNumber);
+            } else if (_jmsMessageType.compare("JMS_OBJECTMESSAGE_TYPE") == 0) {
+                setObjectMessage(msg, *subType, testValue);
+            } else if (_jmsMessageType.compare("JMS_STREAMMESSAGE_TYPE") == 0) {
+                setStreamMessage(msg, *subType, testValue.asString());
+            } else if (_jmsMessageType.compare("JMS_TEXTMESSAGE_TYPE") == 0) {
+                setTextMessage(msg, testValue);
+            } else {
+                throw qpidit::UnknownJmsMessageTypeError(_jmsMessageType);
+            }
+            addMessageHeaders(msg);
+            addMessageProperties(msg);
+            s.send(msg);
         }
 
         proton::message& Sender::setMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr) {
@@ -45,6 +45,7 @@ namespace qpidit
             const Json::Value _testValueMap;
             const Json::Value _testHeadersMap;
             const Json::Value _testPropertiesMap;
+            Json::Value::Members _subTypes; // sorted, sets the send order
             uint32_t _msgsSent;
             uint32_t _msgsConfirmed;
             uint32_t _totalMsgs;
@@ -57,7 +58,7 @@ namespace qpidit
             void on_tracker_accept(proton::tracker &t);
             void on_transport_close(proton::transport &t);
         protected:
-            void  sendMessages(proton::sender &s, const std::string& subType, const Json::Value& testValueMap);
+            void sendMessage(proton::sender &s, uint32_t msgNum);
             proton::message& setMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr);
             proton::message& setBytesMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr);
             proton::message& setMapMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr, uint32_t valueNumber);
@@ -43,6 +43,7 @@ namespace qpidit
             const std::string _brokerUrl;
             const std::string _jmsMessageType;
             const Json::Value _testValueMap;
+            Json::Value::Members _subTypes; // sorted, sets the send order
             uint32_t _msgsSent;
             uint32_t _msgsConfirmed;
             uint32_t _totalMsgs;
@@ -55,7 +56,7 @@ namespace qpidit
             void on_tracker_accept(proton::tracker &t);
             void on_transport_close(proton::transport &t);
         protected:
-            void  sendMessages(proton::sender &s, const std::string& subType, const Json::Value& testValueMap);
+            void sendMessage(proton::sender &s, uint32_t msgNum);
             proton::message& setMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr);
             proton::message& setBytesMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr);
             proton::message& setMapMessage(proton::message& msg, const std::string& subType, const std::string& testValueStr, uint32_t valueNumber);
@@ -26,8 +26,10 @@ Module to generate test data files for the AMQP complex types test
 import argparse
 import json
 import os.path
+import struct
 import sys
 import time
+import uuid
 from abc import abstractmethod
 
 COPYRIGHT_TEXT = """Licensed to the Apache Software Foundation (ASF) under one
@@ -367,70 +369,188 @@ class PythonGenerator(Generator):
 
 
 #pylint: disable=too-many-instance-attributes
-class CppGenerator(Generator):
-    """C++ code generator"""
+class AmqpEncoder:
+    """
+    Encodes JSON data pairs ['amqp_type', value] in AMQP 1.0 wire format. Each value is given the widest encoding of
+    its type, which is also the one used for array elements, so that a value encodes the same in and out of arrays.
+    Values are interpreted as the C++ test data always compiled them, so that for example string, symbol and
+    non-hex binary values may contain C escapes (\\xHH).
+    """
+
+    TYPE_CODES = {'null': 0x40,
+                  'boolean': 0x56,
+                  'ubyte': 0x50,
+                  'ushort': 0x60,
+                  'uint': 0x70,
+                  'ulong': 0x80,
+                  'byte': 0x51,
+                  'short': 0x61,
+                  'int': 0x71,
+                  'long': 0x81,
+                  'float': 0x72,
+                  'double': 0x82,
+                  'decimal32': 0x74,
+                  'decimal64': 0x84,
+                  'decimal128': 0x94,
+                  'char': 0x73,
+                  'timestamp': 0x83,
+                  'uuid': 0x98,
+                  'binary': 0xb0,
+                  'string': 0xb1,
+                  'symbol': 0xb3,
+                  'list': 0xd0,
+                  'map': 0xd1,
+                  'array': 0xf0,
+                 }
+    NUMERIC_FORMATS = {'ubyte': '>B',
+                       'ushort': '>H',
+                       'uint': '>I',
+                       'ulong': '>Q',
+                       'byte': '>b',
+                       'short': '>h',
+                       'int': '>i',
+                       'long': '>q',
+                       'char': '>I', # UTF-32 code point
+                       'timestamp': '>q', # ms since the epoch
+                       'float': '>f',
+                       'double': '>d',
+                      }
+    FIXED_BYTES_SIZES = {'decimal32': 4, 'decimal64': 8, 'decimal128': 16, 'uuid': 16}
+    C_ESCAPES = {'0': '\0', 'a': '\a', 'b': '\b', 'f': '\f', 'n': '\n', 'r': '\r', 't': '\t', 'v': '\v'}
 
-    CODE_SEGMET_A = '''#include <iostream>
-#include <qpidit/amqp_complex_types_test/Common.hpp>
+    @staticmethod
+    def encode(data_pair):
+        """Return data_pair encoded as bytes, starting with its constructor"""
+        amqp_type = data_pair[0]
+        if amqp_type not in AmqpEncoder.TYPE_CODES:
+            raise RuntimeError('Unknown AMQP type \'%s\'' % amqp_type)
+        return bytes([AmqpEncoder.TYPE_CODES[amqp_type]]) + AmqpEncoder._encode_value(data_pair)
 
-namespace qpidit {
-    namespace amqp_complex_types_test {
+    @staticmethod
+    def _encode_value(data_pair):
+        """Return data_pair encoded as bytes, without its constructor"""
+        amqp_type, value = data_pair
+        if amqp_type == 'null':
+            return b''
+        if amqp_type == 'boolean':
+            return b'\x01' if value else b'\x00'
+        if amqp_type in AmqpEncoder.NUMERIC_FORMATS:
+            return struct.pack(AmqpEncoder.NUMERIC_FORMATS[amqp_type], AmqpEncoder._number(amqp_type, value))
+        if amqp_type in AmqpEncoder.FIXED_BYTES_SIZES:
+            return AmqpEncoder._fixed_bytes(amqp_type, value)
+        if amqp_type in ('binary', 'string', 'symbol'):
+            value_bytes = AmqpEncoder._variable_bytes(amqp_type, value)
+            return struct.pack('>I', len(value_bytes)) + value_bytes
+        if amqp_type in ('list', 'map'):
+            if not isinstance(value, list):
+                raise RuntimeError('AMQP %s value not a list, found %s' % (amqp_type, type(value)))
+            if amqp_type == 'map' and len(value) % 2 != 0:
+                raise RuntimeError('AMQP map value list not even, contains %d items' % len(value))
+            elements = b''.join(AmqpEncoder.encode(value_data_pair) for value_data_pair in value)
+            return struct.pack('>II', 4 + len(elements), len(value)) + elements
+        if amqp_type == 'array':
+            if not isinstance(value, list):
+                raise RuntimeError('AMQP array value not a list, found %s' % type(value))
+            element_type = value[0][0] if value else 'null'
+            for value_data_pair in value:
+                if value_data_pair[0] != element_type:
+                    raise RuntimeError('AMQP array of type %s has element of type %s' %
+                                       (element_type, value_data_pair[0]))
+            elements = b''.join(AmqpEncoder._encode_value(value_data_pair) for value_data_pair in value)
+            return struct.pack('>IIB', 5 + len(elements), len(value), AmqpEncoder.TYPE_CODES[element_type]) + \
+                   elements
+        raise RuntimeError('Unknown AMQP type \'%s\'' % amqp_type)
 
-        void Common::initializeDataMap() {
-            if (_testDataMap.empty()) {
-                try {
-'''
+    @staticmethod
+    def _number(amqp_type, value):
+        """Return value as a Python number: floating point values may be 'inf', '-inf' or 'NaN', others hex"""
+        if amqp_type in ('float', 'double'):
+            return float(value)
+        if amqp_type == 'char' and len(value) == 1:
+            return ord(value)
+        if isinstance(value, str):
+            return int(value, 16) if amqp_type == 'char' else int(value, 0)
+        return value
 
-    CODE_SEGMENT_B = '''                } catch (const std::exception& e) {
-                    std::cerr << e.what() << std::endl;
-                }
-            } // if (_dataMap.empty())
-        } // void Common::initializeDataMap()
+    @staticmethod
+    def _fixed_bytes(amqp_type, value):
+        """Return decimal or UUID bytes. Hex values are big-endian numbers, others UUID strings"""
+        size = AmqpEncoder.FIXED_BYTES_SIZES[amqp_type]
+        if isinstance(value, str) and value[:2] == '0x':
+            return int(value, 16).to_bytes(size, 'big')
+        if amqp_type == 'uuid':
+            return uuid.UUID(value).bytes
+        raise RuntimeError('AMQP %s value not a hex string, found %s' % (amqp_type, value))
 
-    } // namespace amqp_complex_types_test
-} // namespace qpidit
-'''
+    @staticmethod
+    def _variable_bytes(amqp_type, value):
+        """Return binary, string or symbol bytes"""
+        if amqp_type == 'binary':
+            if isinstance(value, int):
+                value = hex(value)
+            if value[:2] == '0x':
+                hex_str = value[2:]
+                if len(hex_str) % 2 > 0: # make string even no. of hex chars, prefix with '0' if needed
+                    hex_str = '0%s' % hex_str
+                return bytes.fromhex(hex_str)
+        return AmqpEncoder._c_string_bytes(value)
 
-    PROTON_TYPES = ['decimal32', 'decimal64', 'decimal128', 'timestamp', 'uuid', 'binary', 'symbol']
-    COMPLEX_TYPES = ['array', 'list', 'map']
+    @staticmethod
+    def _c_string_bytes(value):
+        """Return the bytes of value as a C string literal: only escapes \\xHH and \\X are accepted"""
+        value_bytes = bytearray()
+        index = 0
+        while index < len(value):
+            if value[index] == '\\' and index + 1 < len(value):
+                if value[index + 1] == 'x':
+                    value_bytes.append(int(value[index + 2:index + 4], 16))
+                    index += 4
+                else:
+                    value_bytes.extend(AmqpEncoder.C_ESCAPES.get(value[index + 1], value[index + 1]).encode('utf-8'))
+                    index += 2
+            else:
+                value_bytes.extend(value[index].encode('utf-8'))
+                index += 1
+        return bytes(value_bytes)
+
+
+class CppGenerator(Generator):
+    """
+    C++ code generator. Each test value is written AMQP-encoded, as a constexpr byte array, so that shims neither
+    compile nor run code to build test values: the sender decodes the bytes straight into the message body, and the
+    receiver compares against them.
+    """
+
+    CODE_SEGMET_A = """#include <qpidit/amqp_complex_types_test/Common.hpp>
+
+namespace qpidit {
+    namespace amqp_complex_types_test {
+
+        namespace {
+"""
 
-    class ComplexInstanceContext:
-        """Context used for writing complex type instances"""
-        def __init__(self, container_name, instance_name_list, push_flag, indent_level):
-            self._container_name = container_name
-            self._instance_name_list = instance_name_list
-            self._push_flag = push_flag
-            self._indent_level = indent_level
+    CODE_SEGMENT_B = """
+        } // namespace
 
-        def container_name(self):
-            """Return container name"""
-            return self._container_name
+        // Sorted by AMQP type, then AMQP sub-type, for Common::findTestDataEntry(). The encoded size excludes the
+        // null terminating each string literal.
+        const Common::TestDataEntry_t Common::s_testData[] = {
+"""
 
-        def instance_name_list(self):
-            """Return instance name list"""
-            return self._instance_name_list
+    CODE_SEGMENT_C = """        };
 
-        def push_flag(self):
-            """Return push flag"""
-            return self._push_flag
+        const std::size_t Common::s_testDataSize = sizeof(Common::s_testData) / sizeof(Common::s_testData[0]);
 
-        def indent_level(self):
-            """Return indent level"""
-            return self._indent_level
+    } // namespace amqp_complex_types_test
+} // namespace qpidit
+"""
 
+    BYTES_PER_LINE = 16
+    COMPLEX_TYPES = ['array', 'list', 'map']
 
     def __init__(self, target_file_name):
         super().__init__(target_file_name)
-        self.d32_count = 0
-        self.d64_count = 0
-        self.d128_count = 0
-        self.ts_count = 0
-        self.uuid_count = 0
-        self.bin_count = 0
-        self.sym_count = 0
-        self.arr_count = 0
-        self.list_count = 0
-        self.map_count = 0
+        self.test_data_entries = {} # (AMQP type, AMQP sub-type) -> name of the encoded test value
 
     def write_prefix(self):
         """Write comments, copyright, etc. at top of C++ source file"""
@@ -447,384 +567,55 @@ namespace qpidit {
         self.target_file.write(CppGenerator.CODE_SEGMET_A)
 
     def write_code(self, amqp_test_type, json_data):
-        """Write C++ code from json_data"""
-        indent_level = 5
-        indent_str = ' ' * (indent_level * INDENT_LEVEL_SIZE)
-        container_name = '%s_list' % amqp_test_type
-        container_type = 'std::vector<proton::value>'
+        """
+        Write C++ code from json_data: one encoded byte array per test value, entered in the table under the sub-types
+        it is looked up by.
+        """
+        indent_str = ' ' * (3 * INDENT_LEVEL_SIZE)
         hdr_line = '*' * (17 + len(amqp_test_type))
         self.target_file.write('\n%s/*%s\n' % (indent_str, hdr_line))
         self.target_file.write('%s*** AMQP type: %s ***\n' % (indent_str, amqp_test_type))
-        self.target_file.write('%s%s*/\n\n' % (indent_str, hdr_line))
-        self.target_file.write('%s%s %s;\n\n' % (indent_str, container_type, container_name))
-        self._pre_write_list(indent_level, container_name, json_data, True)
-        self.target_file.write('%s_testDataMap.insert(std::pair<const std::string, %s >("%s", %s));\n\n' %
-                               (indent_str, container_type, amqp_test_type, container_name))
+        self.target_file.write('%s%s*/\n' % (indent_str, hdr_line))
+        for index, data_pair in enumerate(json_data):
+            if data_pair[0] not in CppGenerator.COMPLEX_TYPES:
+                continue
+            array_name = '%s_%d' % (amqp_test_type, index)
+            sub_types = CppGenerator._amqp_sub_types(data_pair)
+            self.target_file.write('\n%s// %s\n' % (indent_str, ', '.join(sub_types)))
+            self.target_file.write('%sconstexpr char %s[] =' % (indent_str, array_name))
+            encoded = AmqpEncoder.encode(data_pair)
+            for offset in range(0, len(encoded), CppGenerator.BYTES_PER_LINE):
+                line = encoded[offset:offset + CppGenerator.BYTES_PER_LINE]
+                self.target_file.write('\n%s    "%s"' % (indent_str, ''.join('\\x%02x' % byte for byte in line)))
+            self.target_file.write(';\n')
+            for sub_type in sub_types:
+                # The first value of a sub-type is the one tested, later ones are never looked up
+                self.test_data_entries.setdefault((amqp_test_type, sub_type), array_name)
 
     def write_postfix(self):
-        """Write postfix at bottom of C++ source file"""
+        """Write the sorted table of test values at bottom of C++ source file"""
+        indent_str = ' ' * (3 * INDENT_LEVEL_SIZE)
         self.target_file.write(CppGenerator.CODE_SEGMENT_B)
+        for (amqp_type, amqp_sub_type), array_name in sorted(self.test_data_entries.items()):
+            self.target_file.write('%s{"%s", "%s", %s, sizeof(%s) - 1},\n' %
+                                   (indent_str, amqp_type, amqp_sub_type, array_name, array_name))
+        self.target_file.write(CppGenerator.CODE_SEGMENT_C)
         self.target_file.write('// <eof>\n')
 
-    def _pre_write_list(self, indent_level, container_name, value, push_flag=False):
-        """If a value in a list is a complex or proton type, write instances before the list itself is written"""
-        instance_name_list = []
-        for value_data_pair in value:
-            if value_data_pair[0] in CppGenerator.COMPLEX_TYPES:
-                context = self.ComplexInstanceContext(container_name, instance_name_list, push_flag, indent_level)
-                self._write_complex_instance(value_data_pair, context)
-            elif value_data_pair[0] in CppGenerator.PROTON_TYPES:
-                self._write_proton_instance(indent_level, value_data_pair, instance_name_list)
-        return instance_name_list
-
-    def _write_complex_instance(self, data_pair, context):
-        """Generate c++ code for a complex instance"""
-        amqp_type, value = data_pair
-        if amqp_type not in CppGenerator.COMPLEX_TYPES:
-            raise RuntimeError('AMQP type %s is not complex (one of %s)' % (amqp_type, CppGenerator.COMPLEX_TYPES))
-        if not isinstance(value, list):
-            raise RuntimeError('AMQP %s value not a list, found %s' % (amqp_type, type(value)))
-        CppGenerator.INSTANCE_GENERATE_FN[amqp_type](self, value, context)
-
-    def _write_array_instance(self, value, context):
-        """Generate c++ code for an array instance"""
-        indent_str = ' ' * (context.indent_level() * INDENT_LEVEL_SIZE)
-        inner_instance_name_list = self._pre_write_list(context.indent_level(), context.container_name(), value)
-        self.arr_count += 1
-        array_cpp_type = CppGenerator._array_cpp_type(value)
-        self.target_file.write('%s%s array_%d = {' %
-                               (indent_str, CppGenerator._cpp_type('array', array_cpp_type), self.arr_count))
-        context.instance_name_list().append('pv_array_%d' % self.arr_count)
-        for value_data_pair in value:
-            self._write_data_pair(value_data_pair, inner_instance_name_list)
-        if value and value[0][0] in CppGenerator.COMPLEX_TYPES:
-            self.target_file.write('};\n%sproton::value pv_array_%d;\n' % (indent_str, self.arr_count))
-            self.target_file.write('%sproton::codec::encoder(pv_array_%d) << '
-                                   'proton::codec::encoder::array(array_%d, %s);\n' %
-                                   (indent_str, self.arr_count, self.arr_count,
-                                    CppGenerator._array_proton_type(value)))
-        else:
-            self.target_file.write('};\n%sproton::value pv_array_%d = array_%d;\n' %
-                                   (indent_str, self.arr_count, self.arr_count))
-        if context.push_flag():
-            self.target_file.write('%s%s.push_back(pv_array_%d);\n\n' %
-                                   (indent_str, context.container_name(), self.arr_count))
-
-    def _write_list_instance(self, value, context):
-        """Generate c++ code for a list instance"""
-        indent_str = ' ' * (context.indent_level() * INDENT_LEVEL_SIZE)
-        inner_instance_name_list = self._pre_write_list(context.indent_level(), context.container_name(), value)
-        self.list_count += 1
-        self.target_file.write('%sstd::vector<proton::value> list_%d = {' % (indent_str, self.list_count))
-        context.instance_name_list().append('pv_list_%d' % self.list_count)
-        for value_data_pair in value:
-            self._write_data_pair(value_data_pair, inner_instance_name_list)
-        self.target_file.write('};\n%sproton::value pv_list_%d = list_%d;\n' %
-                               (indent_str, self.list_count, self.list_count))
-        if context.push_flag():
-            self.target_file.write('%s%s.push_back(list_%d);\n\n' %
-                                   (indent_str, context.container_name(), self.list_count))
-
-    def _write_map_instance(self, value, context):
-        """Generate c++ code for a map instance"""
-        indent_str = ' ' * (context.indent_level() * INDENT_LEVEL_SIZE)
-        if len(value) % 2 != 0:
-            raise RuntimeError('AMQP map value list not even, contains %d items' % len(value))
-        inner_instance_name_list = self._pre_write_list(context.indent_level(), context.container_name(), value)
-        self.map_count += 1
-        self.target_file.write('%sstd::vector<std::pair<proton::value, proton::value> > map_%d = {' %
-                               (indent_str, self.map_count))
-        context.instance_name_list().append('pv_map_%d' % self.map_count)
-        # consume list in pairs (key, value)
-        value_iter = iter(value)
-        for value_data_pair in value_iter:
-            self.target_file.write('std::pair<proton::value, proton::value>(')
-            self._write_data_pair(value_data_pair, inner_instance_name_list)
-            value_data_pair = next(value_iter)
-            self._write_data_pair(value_data_pair, inner_instance_name_list, False)
-            self.target_file.write('), ')
-        self.target_file.write('};\n%sproton::value pv_map_%d;\n' % (indent_str, self.map_count))
-        self.target_file.write('%sproton::codec::encoder(pv_map_%d) << proton::codec::encoder::map(map_%d);\n' %
-                               (indent_str, self.map_count, self.map_count))
-        if context.push_flag():
-            self.target_file.write('%s%s.push_back(map_%d);\n\n' %
-                                   (indent_str, context.container_name(), self.map_count))
-
-    @staticmethod
-    def _array_cpp_type(data_list):
-        """Return a cpp type string for use in array type encoding"""
-        if data_list: # List not empty
-            if data_list[0][0] in CppGenerator.COMPLEX_TYPES:
-                return 'proton::value'
-            # The type of the first element is assumed to be the type of the array
-            return CppGenerator._cpp_type(data_list[0][0])
-        return 'std::nullptr_t'
-
-    @staticmethod
-    def _array_proton_type(data_list):
-        """Return a Proton cpp type string used in the proton::codec::encoder::array() function"""
-        if data_list:
-            data_list_type = data_list[0][0]
-            if data_list_type == 'array':
-                return 'proton::ARRAY'
-            if data_list_type == 'list':
-                return 'proton::LIST'
-            if data_list_type == 'map':
-                return 'proton::MAP'
-        return None
-
-    def _write_proton_instance(self, indent_level, data_pair, instance_name_list):
-        """
-        Proton types do not yet support literals. Write proton values as instances, place assigned variable name
-        onto instance_name_list so they can be placed into the AMQP complex type container.
-        """
-        indent_str = ' ' * (indent_level * INDENT_LEVEL_SIZE)
-        amqp_type, value = data_pair
-        CppGenerator.INSTANCE_GENERATE_FN[amqp_type](self, indent_str, value, instance_name_list)
-
-    def _write_decimal32_instance(self, indent_str, value, instance_name_list):
-        """Write proton::decimal32 instance"""
-        self.d32_count += 1
-        self.target_file.write('%sproton::decimal32 d32_%d;\n' % (indent_str, self.d32_count))
-        self.target_file.write('%shexStringToBytearray(d32_%d, "%s");\n' %
-                               (indent_str, self.d32_count, value[2:]))
-        instance_name_list.append('d32_%d' % self.d32_count)
-
-    def _write_decimal64_instance(self, indent_str, value, instance_name_list):
-        """Write proton::decimal64 instance"""
-        self.d64_count += 1
-        self.target_file.write('%sproton::decimal64 d64_%d;\n' % (indent_str, self.d64_count))
-        self.target_file.write('%shexStringToBytearray(d64_%d, "%s");\n' %
-                               (indent_str, self.d64_count, value[2:]))
-        instance_name_list.append('d64_%d' % self.d64_count)
-
-    def _write_decimal128_instance(self, indent_str, value, instance_name_list):
-        """Write proton::decimal128 instance"""
-        self.d128_count += 1
-        self.target_file.write('%sproton::decimal128 d128_%d;\n' % (indent_str, self.d128_count))
-        self.target_file.write('%shexStringToBytearray(d128_%d, "%s");\n' %
-                               (indent_str, self.d128_count, value[2:]))
-        instance_name_list.append('d128_%d' % self.d128_count)
-
-    def _write_timestamp_instance(self, indent_str, value, instance_name_list):
-        """Write proton::timestamp instance"""
-        self.ts_count += 1
-        radix = 16 if isinstance(value, str) and len(value) > 2 and value[:2] == '0x' else 10
-        if radix == 16: # hex string
-            self.target_file.write('%sproton::timestamp ts_%d(std::strtoul(' % (indent_str, self.ts_count) +
-                                   'std::string("%s").data(), nullptr, 16));\n' % value[2:])
-        else:
-            self.target_file.write('%sproton::timestamp ts_%d(%s);\n' % (indent_str, self.ts_count, value))
-        instance_name_list.append('ts_%d' % self.ts_count)
-
-    def _write_uuid_instance(self, indent_str, value, instance_name_list):
-        """Write proton::uuid instance"""
-        self.uuid_count += 1
-        self.target_file.write('%sproton::uuid uuid_%d;\n' % (indent_str, self.uuid_count))
-        if isinstance(value, str) and len(value) > 2 and value[:2] == '0x': # Hex string "0x..."
-            # prefix hex strings < 32 chars (16 bytes) with 0s to make exactly 32 chars long
-            fill_size = 32 - len(value[2:])
-            uuid_hex_str = '%s%s' % ('0' * fill_size, value[2:])
-            self.target_file.write('%shexStringToBytearray(uuid_%d, "%s");\n' %
-                                   (indent_str, self.uuid_count, uuid_hex_str))
-        else: # UUID format "00000000-0000-0000-0000-000000000000"
-            self.target_file.write('%ssetUuid(uuid_%d, "%s");\n' % (indent_str, self.uuid_count, value))
-        instance_name_list.append('uuid_%d' % self.uuid_count)
-
     @staticmethod
-    def _get_delimited_string_length(mixed_string):
+    def _amqp_sub_types(data_pair):
         """
-        Get the final length of a string literal in bytes, given that there may be embedded delimited chars
-        eg. _get_delimited_string_length('abc\t\x00\x01\x02\ndef\0') = 12
-        Only delimited strings of the form \\X (eg \\n, \\t, \\0) or hex values \\xXX are accepted
+        Return the AMQP sub-types by which a test value is looked up: "None" if it is empty, otherwise the type of
+        its first element (for maps, the first value rather than key), and also "*" for a multi-typed list or map
+        whose first element is the string "*".
         """
-        char_count = 0
-        delimit_flag = False
-        delimit_count = 0
-        for this_char in mixed_string:
-            if delimit_flag:
-                if delimit_count: # value > 0
-                    delimit_count -= 1
-                    if not delimit_count:
-                        delimit_flag = False
-                        char_count += 1
-                else:
-                    if this_char == 'x':
-                        delimit_count = 2
-                    else:
-                        delimit_flag = False
-                        char_count += 1
-            elif this_char == '\\':
-                delimit_flag = True
-            else:
-                char_count += 1
-        return char_count
-
-    def _write_binary_instance(self, indent_str, value, instance_name_list):
-        """Write proton::binary instance"""
-        self.bin_count += 1
-        if isinstance(value, int) or ((isinstance(value, str) and len(value) > 2 and value[:2] == '0x')): # numeric
-            hex_str = '{:02x}'.format(value) if isinstance(value, int) else value[2:]
-            if len(hex_str) % 2 > 0: # make string even no. of hex chars, prefix with '0' if needed
-                hex_str = '0%s' % hex_str
-            self.target_file.write('%sproton::binary bin_%d(std::string("' % (indent_str, self.bin_count))
-            #pylint: disable=consider-using-enumerate
-            for i in range(len(hex_str)):
-                if not i % 2:
-                    self.target_file.write('\\x')
-                self.target_file.write(hex_str[i])
-            self.target_file.write('", %d));\n' % (len(hex_str)/2))
-        else: # string
-            self.target_file.write('%sproton::binary bin_%d(std::string("%s", %d));\n' %
-                                   (indent_str, self.bin_count, value,
-                                    CppGenerator._get_delimited_string_length(value)))
-        instance_name_list.append('bin_%d' % self.bin_count)
-
-    def _write_symbol_instance(self, indent_str, value, instance_name_list):
-        """Write proton::symbol instance"""
-        self.sym_count += 1
-        self.target_file.write('%sproton::symbol sym_%d("%s");\n' % (indent_str, self.sym_count, value))
-        instance_name_list.append('sym_%d' % self.sym_count)
-
-    #pylint: disable=too-many-branches
-    #pylint: disable=too-many-statements
-    def _write_data_pair(self, data_pair, instance_name_list=None, trailing_comma_flag=True):
-        """
-        Write a JOSN pair ['amqp_type', value]. If amqp_type is complex or a proton type, pop instance name from
-        intance_name_list (which has been previously declared).
-        """
-        trailing_comma_string = ', ' if trailing_comma_flag else ''
         amqp_type, value = data_pair
-        if amqp_type == 'null':
-            self.target_file.write('nullptr%s' % trailing_comma_string)
-        elif amqp_type == 'boolean':
-            self.target_file.write('%s%s' % (str(value).lower(), trailing_comma_string))
-        elif amqp_type == 'ubyte':
-            self.target_file.write('uint8_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'byte':
-            self.target_file.write('int8_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'ushort':
-            self.target_file.write('uint16_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'short':
-            self.target_file.write('int16_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'uint':
-            self.target_file.write('uint32_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'int':
-            self.target_file.write('int32_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'ulong':
-            self.target_file.write('uint64_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'long':
-            self.target_file.write('int64_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'float':
-            if isinstance(value, str):
-                if value == 'inf':
-                    self.target_file.write('std::numeric_limits<float>::infinity()%s' % trailing_comma_string)
-                elif value == '-inf':
-                    self.target_file.write('-std::numeric_limits<float>::infinity()%s' % trailing_comma_string)
-                elif value == 'NaN':
-                    self.target_file.write('std::numeric_limits<float>::quiet_NaN()%s' % trailing_comma_string)
-                else:
-                    self.target_file.write('float(%s)%s' % (value, trailing_comma_string))
-            else:
-                self.target_file.write('float(%s)%s' % (str(value), trailing_comma_string))
-        elif amqp_type == 'double':
-            if isinstance(value, str):
-                if value == 'inf':
-                    self.target_file.write('std::numeric_limits<double>::infinity()%s' % trailing_comma_string)
-                elif value == '-inf':
-                    self.target_file.write('-std::numeric_limits<double>::infinity()%s' % trailing_comma_string)
-                elif value == 'NaN':
-                    self.target_file.write('std::numeric_limits<double>::quiet_NaN()%s' % trailing_comma_string)
-                else:
-                    self.target_file.write('double(%s)%s' % (value, trailing_comma_string))
-            else:
-                self.target_file.write('double(%s)%s' % (str(value), trailing_comma_string))
-        elif amqp_type == 'decimal32':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'decimal64':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'decimal128':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'char':
-            if len(value) == 1: # single char
-                self.target_file.write('wchar_t(\'%s\')%s' % (value, trailing_comma_string))
-            else:
-                self.target_file.write('wchar_t(%s)%s' % (value, trailing_comma_string))
-        elif amqp_type == 'timestamp':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'uuid':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'binary':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'string':
-            self.target_file.write('std::string("')
-            for char_ in value:
-                if char_ in ('\'', '"'):
-                    self.target_file.write('\\')
-                self.target_file.write(char_)
-            self.target_file.write('")%s' % trailing_comma_string)
-        elif amqp_type == 'symbol':
-            if instance_name_list is not None:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'array':
-            if instance_name_list is not None and instance_name_list:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'list':
-            if instance_name_list is not None and instance_name_list:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-        elif amqp_type == 'map':
-            if instance_name_list is not None and instance_name_list:
-                self.target_file.write('%s%s' % (instance_name_list.pop(0), trailing_comma_string))
-
-    @staticmethod
-    def _cpp_type(amqp_type, amqp_sub_type=None):
-        cpp_types = {
-            None: 'NULL',
-            'null': 'std::nullptr_t',
-            'boolean': 'bool',
-            'byte': 'int8_t',
-            'ubyte': 'uint8_t',
-            'short': 'int16_t',
-            'ushort': 'uint16_t',
-            'int': 'int32_t',
-            'uint': 'uint32_t',
-            'char': 'wchar_t',
-            'long': 'int64_t',
-            'ulong': 'uint64_t',
-            'timestamp': 'proton::timestamp',
-            'float': 'float',
-            'double': 'double',
-            'decimal32': 'proton::decimal32',
-            'decimal64': 'proton::decimal64',
-            'decimal128': 'proton::decimal128',
-            'uuid': 'proton::uuid',
-            'binary': 'proton::binary',
-            'string': 'std::string',
-            'symbol': 'proton::symbol',
-            'described': 'proton::described',
-            'array': 'std::vector<%s> ' % amqp_sub_type,
-            'list': 'std::vector<proton::value> ',
-            'map': 'std::map<proton::value, proton::value> '
-            }
-        return cpp_types[amqp_type]
-
-    INSTANCE_GENERATE_FN = {'decimal32': _write_decimal32_instance,
-                            'decimal64': _write_decimal64_instance,
-                            'decimal128': _write_decimal128_instance,
-                            'timestamp': _write_timestamp_instance,
-                            'uuid': _write_uuid_instance,
-                            'binary': _write_binary_instance,
-                            'symbol': _write_symbol_instance,
-                            'array': _write_array_instance,
-                            'list': _write_list_instance,
-                            'map': _write_map_instance,
-                           }
+        if not value:
+            return ['None']
+        sub_types = [value[1 if amqp_type == 'map' else 0][0]]
+        if value[0] == ['string', '*']:
+            sub_types.append('*')
+        return sub_types
 
 
 class JavaScriptGenerator(Generator):
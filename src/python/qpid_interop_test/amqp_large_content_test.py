@@ -28,12 +28,33 @@ import sys
 import unittest
 
 from itertools import product
-from json import dumps
+from json import dumps, loads
 
 import qpid_interop_test.qit_common
+import qpid_interop_test.qit_shim
 from qpid_interop_test.qit_errors import InteropTestError, InteropTestTimeout
 
 DEFAULT_TEST_TIMEOUT = 300 # seconds
+# Types whose bodies senders can send from --payload-file. Not string: file bytes need not be valid UTF-8.
+PAYLOAD_FILE_TYPES = ('binary',)
+# Test values of this size in MB and above are only sent between shims which support large messages, as proton's
+# handling of messages this large is too slow for the test timeout in most shims
+LARGE_MESSAGE_SIZE_MB = 100
+
+
+def get_supported_test_values(test_value_list, send_shim, receive_shim):
+    """Return the test values without the large message sizes, unless both shims support large messages"""
+    if send_shim.LARGE_MESSAGE_SEND_SUPPORTED and receive_shim.LARGE_MESSAGE_RECEIVE_SUPPORTED:
+        return test_value_list
+    return [test_value for test_value in test_value_list
+            if (test_value[0] if isinstance(test_value, list) else test_value) < LARGE_MESSAGE_SIZE_MB]
+
+
+def get_payload_options(amqp_type, send_shim, payload_options):
+    """Return the sender options for --payload-file if they apply to this type and sender, otherwise None"""
+    if payload_options and amqp_type in PAYLOAD_FILE_TYPES and send_shim.PAYLOAD_FILE_SUPPORTED:
+        return payload_options
+    return None
 
 
 class AmqpVariableSizeTypes(qpid_interop_test.qit_common.QitTestTypeMap):
@@ -42,54 +63,99 @@ class AmqpVariableSizeTypes(qpid_interop_test.qit_common.QitTestTypeMap):
     """
 
     type_map = {
-        # List of sizes in Mb (1024*1024 bytes)
-        # TODO: Until the issue of SLOW Proton performance for large messages is solved, the 100MB tests are
-        # disabled.
-        'binary': [1, 10, #100],
-                  ],
-        'string': [1, 10, #100],
-                  ],
-        'symbol': [1, 10, #100],
-                  ],
+        # List of sizes in Mb (1024*1024 bytes). Sizes from LARGE_MESSAGE_SIZE_MB need shims supporting large messages.
+        'binary': [1, 10, 100],
+        'string': [1, 10, 100],
+        'symbol': [1, 10, 100],
         # Tuple of two elements: (tot size of list/map in MB, List of no elements in list)
         # The num elements lists are powers of 2 so that they divide evenly into the size in MB (1024 * 1024 bytes)
         'list': [[1, [1, 16, 256, 4096]],
                  [10, [1, 16, 256, 4096]],
-                 #[100, [1, 16, 256, 4096]]
+                 [100, [1, 16, 256, 4096]],
                 ],
         'map': [[1, [1, 16, 256, 4096]],
                 [10, [1, 16, 256, 4096]],
-                #[100, [1, 16, 256, 4096]]],
+                [100, [1, 16, 256, 4096]],
                ],
         #'array': [[1, [1, 16, 256, 4096]], [10, [1, 16, 256, 4096]], [100, [1, 16, 256, 4096]]]
         }
 
+    # Selected by --stress in place of type_map: lists and maps of 10**5 to 10**7 elements, which show per-element
+    # encode and decode costs hidden by the few elements above. 2**23 elements need a size that is a multiple of 8 MB.
+    stress_type_map = {
+        'list': [[16, [2**17, 2**20, 2**23]],
+                 [128, [2**17, 2**20, 2**23]],
+                ],
+        'map': [[16, [2**17, 2**20, 2**23]],
+                [128, [2**17, 2**20, 2**23]],
+               ],
+        }
+
     # This section contains tests that should be skipped because of known broker issues that would cause the
     # test to fail. As the issues are resolved, these should be removed.
     broker_skip = {}
 
     client_skip = {}
 
+    def get_types(self, args):
+        """Return the list of types, which are the stress types with --stress"""
+        if args.stress:
+            self.type_map = dict(self.stress_type_map)
+        return super().get_types(args)
+
+
+class SizeRecordCollector(qpid_interop_test.qit_shim.RecordCollector):
+    """
+    Rebuilds a received value list from the records of a streaming receiver. Binary, string and symbol records
+    are sizes in MB, kept in order. List and map records are [size, num_elements], grouped by size into
+    [size, [num_elements, ...]] in the order each size was first received.
+    """
+    def __init__(self, amqp_type):
+        super().__init__()
+        self.amqp_type = amqp_type
+        self.size_index = {}
+
+    def add(self, record):
+        if self.amqp_type in ('list', 'map'):
+            size, num_elements = record
+            if size in self.size_index:
+                self.records[self.size_index[size]][1].append(num_elements)
+            else:
+                self.size_index[size] = len(self.records)
+                self.records.append([size, [num_elements]])
+        else:
+            self.records.append(record)
+
 
 class AmqpLargeContentTestCase(qpid_interop_test.qit_common.QitTestCase):
     """Abstract base class for AMQP large content tests"""
 
+    stress_flag = False # --stress: report the receiver's decode cost
+    payload_options = None # --payload-file: sender options to send bodies from the file
+
     #pylint: disable=too-many-arguments
     def run_test(self, sender_addr, receiver_addr, amqp_type, test_value_list, send_shim, receive_shim, timeout):
         """
         Run this test by invoking the shim send method to send the test values, followed by the shim receive method
         to receive the values. Finally, compare the sent values with the received values.
         """
+        if not self.stress_flag: # --stress selects its large sizes explicitly
+            test_value_list = get_supported_test_values(test_value_list, send_shim, receive_shim)
         if test_value_list: # len > 0
             queue_name = 'qit.amqp_large_content_test.%s.%s.%s' % \
                          (amqp_type, send_shim.NAME, receive_shim.NAME)
 
             # Start the receive shim first (for queueless brokers/dispatch)
+            decode_cost_flag = self.stress_flag and receive_shim.DECODE_COST_SUPPORTED
             receiver = receive_shim.create_receiver(receiver_addr, queue_name, amqp_type,
-                                                    str(self.get_num_messages(amqp_type, test_value_list)))
+                                                    str(self.get_num_messages(amqp_type, test_value_list)),
+                                                    stream_flag=True,
+                                                    options=['--decode-cost'] if decode_cost_flag else None,
+                                                    record_collector=SizeRecordCollector(amqp_type))
 
             # Start the send shim
-            sender = send_shim.create_sender(sender_addr, queue_name, amqp_type, dumps(test_value_list))
+            sender = send_shim.create_sender(sender_addr, queue_name, amqp_type, dumps(test_value_list),
+                                             options=get_payload_options(amqp_type, send_shim, self.payload_options))
 
             # Wait for sender, process return string
             try:
@@ -116,12 +182,24 @@ class AmqpLargeContentTestCase(qpid_interop_test.qit_common.QitTestCase):
                                      (amqp_type, return_amqp_type))
                     self.assertEqual(return_test_value_list, test_value_list, msg='\n    sent:%s\nreceived:%s' % \
                                      (test_value_list, return_test_value_list))
+                    if decode_cost_flag:
+                        self.print_decode_cost(receive_shim, receiver.summary)
                 else:
                     raise InteropTestError('Receive shim \'%s\':\n%s' % (receive_shim.NAME, receive_obj))
             else:
                 raise InteropTestError('Receive shim \'%s\':\n%s' % (receive_shim.NAME, receive_obj))
 
 
+    @staticmethod
+    def print_decode_cost(receive_shim, summary):
+        """Print the per-element decode cost reported in a receiver's summary"""
+        decode_cost = summary.get('decodeCost') if isinstance(summary, dict) else None
+        if decode_cost is None:
+            raise InteropTestError('Receive shim \'%s\': No decode cost in summary %s' % (receive_shim.NAME, summary))
+        print('\n  %s receiver: %d elements, decode %.1f ns/element, walk and verify %.1f ns/element' %
+              (receive_shim.NAME, decode_cost['elements'], decode_cost['decodeNsPerElement'],
+               decode_cost['walkNsPerElement']))
+
     @staticmethod
     def get_num_messages(amqp_type, test_value_list):
         """Find the total number of messages to be sent for this test"""
@@ -136,6 +214,100 @@ class AmqpLargeContentTestCase(qpid_interop_test.qit_common.QitTestCase):
 
 
 
+class SizeSweep:
+    """
+    Benchmark which sends bodies of geometrically increasing size between each pair of shims that supports it, to
+    find where a client and broker combination falls off a performance cliff. Each step sends enough messages of
+    one size to carry about bytes_per_step bytes (at least one, at most MAX_MESSAGES_PER_STEP), and writes one point
+    of the curve as a line of JSON with members amqpType, sender, receiver, sizeBytes, messages, sendSeconds,
+    receiveSeconds, transferSeconds, mbPerSec, senderPeakRssKb and receiverPeakRssKb.
+
+    sendSeconds runs from the sender's first credit to its last message being accepted, receiveSeconds from the
+    first message arriving at the receiver to the last. transferSeconds runs from the sender starting to the
+    receiver getting the last message (both shims run on this host, so their monotonic clocks agree), and gives
+    the throughput mbPerSec.
+    """
+    MAX_MESSAGES_PER_STEP = 10000
+
+    #pylint: disable=too-many-arguments
+    def __init__(self, sender_addr, receiver_addr, amqp_types, shims, sizes, bytes_per_step, timeout, out,
+                 payload_options=None):
+        self.sender_addr = sender_addr
+        self.receiver_addr = receiver_addr
+        self.amqp_types = amqp_types
+        self.shims = shims
+        self.sizes = sizes
+        self.bytes_per_step = bytes_per_step
+        self.timeout = timeout
+        self.out = out
+        self.payload_options = payload_options
+
+    @staticmethod
+    def get_sizes(min_size, max_size, factor):
+        """Return the sizes from min_size, each factor times the last, up to max_size"""
+        if min_size < 1 or max_size < min_size or factor < 2:
+            raise InteropTestError('Size sweep needs 1 <= min size <= max size and factor >= 2')
+        sizes = []
+        size = min_size
+        while size <= max_size:
+            sizes.append(size)
+            size *= factor
+        return sizes
+
+    def run(self):
+        """Run every step, writing each point as soon as it is measured"""
+        for amqp_type in self.amqp_types:
+            for send_shim, receive_shim in product(self.shims, repeat=2):
+                for size in self.sizes:
+                    self.out.write(dumps(self.run_step(amqp_type, send_shim, receive_shim, size)) + '\n')
+                    self.out.flush()
+
+    def run_step(self, amqp_type, send_shim, receive_shim, size):
+        """Send one size between one pair of shims, and return the point of the curve"""
+        num_messages = max(1, min(self.MAX_MESSAGES_PER_STEP, self.bytes_per_step // size))
+        test_value_list = [[size, [1]]] if amqp_type in ('list', 'map') else [size]
+        options = ['--size-bytes', '--repeat', str(num_messages)]
+        queue_name = 'qit.amqp_large_content_test.size_sweep.%s.%s.%s' % (amqp_type, send_shim.NAME, receive_shim.NAME)
+
+        # Start the receive shim first (for queueless brokers/dispatch)
+        receiver = receive_shim.create_receiver(self.receiver_addr, queue_name, amqp_type, '1', options=options)
+        sender = send_shim.create_sender(self.sender_addr, queue_name, amqp_type, dumps(test_value_list),
+                                         options=options + (get_payload_options(amqp_type, send_shim,
+                                                                                self.payload_options) or []))
+        try:
+            send_obj = sender.wait_for_completion(self.timeout)
+        except (KeyboardInterrupt, InteropTestTimeout):
+            receiver.send_signal(signal.SIGINT)
+            raise
+        # The sender prints its stats alone, which the shim output returns as text
+        try:
+            send_stats = loads(send_obj)
+        except (TypeError, ValueError):
+            receiver.send_signal(signal.SIGINT)
+            raise InteropTestError('Send shim \'%s\':\n%s' % (send_shim.NAME, send_obj))
+        receive_obj = receiver.wait_for_completion(self.timeout)
+        if not isinstance(receive_obj, tuple) or len(receive_obj) != 2 or not isinstance(receive_obj[1], dict):
+            raise InteropTestError('Receive shim \'%s\':\n%s' % (receive_shim.NAME, receive_obj))
+        receive_stats = receive_obj[1]
+
+        try:
+            transfer_seconds = (receive_stats['stopMonotonicNs'] - send_stats['startMonotonicNs']) / 1e9
+            return {'amqpType': amqp_type,
+                    'sender': send_shim.NAME,
+                    'receiver': receive_shim.NAME,
+                    'sizeBytes': size,
+                    'messages': num_messages,
+                    'sendSeconds': send_stats['elapsedSeconds'],
+                    'receiveSeconds': receive_stats['elapsedSeconds'],
+                    'transferSeconds': transfer_seconds,
+                    'mbPerSec': num_messages * size / transfer_seconds / (1024 * 1024) if transfer_seconds > 0 else 0.0,
+                    'senderPeakRssKb': send_stats['peakRssKb'],
+                    'receiverPeakRssKb': receive_stats['peakRssKb']}
+        except KeyError as err:
+            raise InteropTestError('Size sweep: stats missing %s\n    sender:%s\n  receiver:%s' %
+                                   (err, send_stats, receive_stats))
+
+
 class TestOptions(qpid_interop_test.qit_common.QitCommonTestOptions):
     """Command-line arguments used to control the test"""
 
@@ -150,6 +322,35 @@ class TestOptions(qpid_interop_test.qit_common.QitCommonTestOptions):
         type_group.add_argument('--exclude-type', action='append', metavar='AMQP-TYPE',
                                 help='Name of AMQP type to exclude. Supported types: see "include-type" above')
 
+        self._parser.add_argument('--stress', action='store_true',
+                                  help='Test lists and maps of 2**17 to 2**23 elements in place of the usual ' +
+                                  'test values, printing the per-element decode cost of receivers which report it')
+
+        payload_group = self._parser.add_argument_group('Payload file options')
+        payload_group.add_argument('--payload-file', action='store', metavar='FILE',
+                                   help='Send %s bodies from the start of FILE, which must be at least as large as ' %
+                                   ' and '.join(PAYLOAD_FILE_TYPES) + 'the largest of them, in place of the test ' +
+                                   'pattern. Only senders which support it do so, receivers check just the CRC32C')
+        payload_group.add_argument('--payload-hugepages', action='store_true',
+                                   help='Have senders hold the payload file in huge pages')
+
+        sweep_group = self._parser.add_argument_group('Size sweep benchmark options')
+        sweep_group.add_argument('--size-sweep', action='store_true',
+                                 help='In place of the tests, send bodies of geometrically increasing size ' +
+                                 'between each pair of shims which supports it, writing the send time, receive ' +
+                                 'time, throughput and peak RSS of each step as a line of JSON')
+        sweep_group.add_argument('--sweep-min-size', action='store', type=int, default=1024, metavar='BYTES',
+                                 help='Smallest body size (%(default)s bytes)')
+        sweep_group.add_argument('--sweep-max-size', action='store', type=int, default=1024 * 1024 * 1024,
+                                 metavar='BYTES', help='Largest body size (%(default)s bytes)')
+        sweep_group.add_argument('--sweep-factor', action='store', type=int, default=4, metavar='N',
+                                 help='Ratio of each body size to the last (%(default)s)')
+        sweep_group.add_argument('--sweep-bytes-per-step', action='store', type=int, default=64 * 1024 * 1024,
+                                 metavar='BYTES', help='Bytes to send at each size, as messages of that size ' +
+                                 '(%(default)s bytes)')
+        sweep_group.add_argument('--sweep-output', action='store', metavar='FILE',
+                                 help='File to write the curve to (default: stdout)')
+
 
 class AmqpLargeContentTest(qpid_interop_test.qit_common.QitTest):
     """Top-level test for AMQP large content (variable-size types)"""
@@ -169,6 +370,30 @@ class AmqpLargeContentTest(qpid_interop_test.qit_common.QitTest):
                                                              int(self.args.timeout))
                 self.test_suite.addTest(unittest.makeSuite(test_case_class))
 
+    def run_size_sweep(self):
+        """Run the size sweep benchmark in place of the tests"""
+        shims = [shim for shim in self.shim_map.values() if shim.SIZE_SWEEP_SUPPORTED]
+        for shim in self.shim_map.values():
+            if not shim.SIZE_SWEEP_SUPPORTED:
+                print('WARNING: %s shims do not support the size sweep' % shim.NAME)
+        sizes = SizeSweep.get_sizes(self.args.sweep_min_size, self.args.sweep_max_size, self.args.sweep_factor)
+        out = sys.stdout if self.args.sweep_output is None else open(self.args.sweep_output, 'w')
+        try:
+            SizeSweep(self.args.sender, self.args.receiver, sorted(self.types.get_type_list()), shims, sizes,
+                      self.args.sweep_bytes_per_step, int(self.args.timeout), out, self.get_payload_options()).run()
+        finally:
+            if out is not sys.stdout:
+                out.close()
+
+    def get_payload_options(self):
+        """Return the sender options for --payload-file, or None if it was not given"""
+        if self.args.payload_file is None:
+            return None
+        options = ['--payload-file', self.args.payload_file]
+        if self.args.payload_hugepages:
+            options.append('--payload-hugepages')
+        return options
+
     def create_testcase_class(self, amqp_type, shim_product, timeout):
         """
         Class factory function which creates new subclasses to AmqpTypeTestCase.
@@ -206,7 +431,9 @@ class AmqpLargeContentTest(qpid_interop_test.qit_common.QitTest):
                       'amqp_type': amqp_type,
                       'sender_addr': self.args.sender,
                       'receiver_addr': self.args.receiver,
-                      'test_value_list': self.types.get_test_values(amqp_type)}
+                      'test_value_list': self.types.get_test_values(amqp_type),
+                      'stress_flag': self.args.stress,
+                      'payload_options': self.get_payload_options()}
         new_class = type(class_name, (AmqpLargeContentTestCase,), class_dict)
         for send_shim, receive_shim in shim_product:
             add_test_method(new_class, send_shim, receive_shim, timeout)
@@ -218,6 +445,9 @@ class AmqpLargeContentTest(qpid_interop_test.qit_common.QitTest):
 if __name__ == '__main__':
     try:
         AMQP_LARGE_CONTENT_TEST = AmqpLargeContentTest()
+        if AMQP_LARGE_CONTENT_TEST.args.size_sweep:
+            AMQP_LARGE_CONTENT_TEST.run_size_sweep()
+            sys.exit(0)
         AMQP_LARGE_CONTENT_TEST.run_test()
         AMQP_LARGE_CONTENT_TEST.write_logs()
         if not AMQP_LARGE_CONTENT_TEST.get_result():
@@ -254,7 +254,8 @@ class AmqpTypeTestCase(qpid_interop_test.qit_common.QitTestCase):
             queue_name = 'qit.%s' % test_name
 
             # Start the receive shim first (for queueless brokers/dispatch)
-            receiver = receive_shim.create_receiver(receiver_addr, queue_name, amqp_type, str(len(test_value_list)))
+            receiver = receive_shim.create_receiver(receiver_addr, queue_name, amqp_type, str(len(test_value_list)),
+                                                    stream_flag=True)
 
             # Start the send shim
             sender = send_shim.create_sender(sender_addr, queue_name, amqp_type, dumps(test_value_list))
@@ -32,20 +32,41 @@ from qpid_interop_test.qit_errors import InteropTestTimeout
 
 class ShimProcess(subprocess.Popen):
     """Abstract parent class for Sender and Receiver shim process"""
-    def __init__(self, params, proc_name):
+    def __init__(self, params, proc_name, record_collector=None):
         self.proc_name = proc_name
+        self.summary = None # Summary line of a streaming receiver, once complete
         self.killed_flag = False
         self.env = copy.deepcopy(os.environ)
         super().__init__(params, stdout=subprocess.PIPE, stderr=subprocess.PIPE, preexec_fn=os.setsid, env=self.env)
+        # Stdout and stderr are drained from the start, so that a shim writing while it runs (such as a streaming
+        # receiver started before its sender) never blocks on a full pipe
+        self.shim_output = ShimOutput(RecordCollector() if record_collector is None else record_collector)
+        self.stderr_chunks = []
+        self.read_error = None
+        self.stdout_thread = threading.Thread(target=self._read_stdout, daemon=True)
+        self.stderr_thread = threading.Thread(target=self._read_stderr, daemon=True)
+        self.stdout_thread.start()
+        self.stderr_thread.start()
 
     def wait_for_completion(self, timeout):
-        """Wait for process to end and return tuple containing (stdout, stderr) from process"""
+        """
+        Wait for process to end and return tuple containing (stdout, stderr) from process. Stdout is read
+        incrementally from the time the process starts: a receiver in streaming mode writes its AMQP type line, one
+        JSON record per line and a summary line (NDJSON), and each record is passed to the record collector as it
+        is read, so that the whole output is never held in memory.
+        """
         timer = threading.Timer(timeout, self._kill, [timeout])
         try:
             timer.start()
-            (stdoutdata, stderrdata) = self.communicate()
-            stdoutstr =  stdoutdata.decode('ascii')
-            stderrstr = stderrdata.decode('ascii')
+            self.stdout_thread.join()
+            self.wait()
+            self.stderr_thread.join()
+            if self.read_error is not None:
+                raise self.read_error
+            shim_output = self.shim_output
+            self.summary = shim_output.summary
+            stdoutstr = shim_output.text()
+            stderrstr = b''.join(self.stderr_chunks).decode('ascii')
             if self.killed_flag:
                 raise InteropTestTimeout('%s: Timeout after %d seconds' % (self.proc_name, timeout))
             if self.returncode != 0:
@@ -57,21 +78,33 @@ class ShimProcess(subprocess.Popen):
                 if not stderrstr.startswith('Got a bad hardware address length for an AF_PACKET') and \
                 "[DEP0005]" not in stderrstr:
                     return 'stderr: %s\nstdout: %s' % (stderrstr, stdoutstr)
-            if not stdoutstr: # zero length
+            if shim_output.empty():
                 return None
-            type_value_list = stdoutstr.split('\n')[0:-1] # remove trailing '\n', split by only remaining '\n'
-            if len(type_value_list) == 2:
-                try:
-                    return (type_value_list[0], json.loads(type_value_list[1])) # Return tuple
-                except ValueError:
-                    return stdoutstr # ERROR: return single string
-            return stdoutstr # ERROR: return single string
+            return shim_output.result()
         except (KeyboardInterrupt) as err:
             self.send_signal(signal.SIGINT)
             raise err
         finally:
             timer.cancel()
 
+    def _read_stdout(self):
+        """
+        Reader thread: passes each line of stdout to the shim output until the process closes it. After an error,
+        which wait_for_completion() raises, the rest is still drained.
+        """
+        with self.stdout:
+            for line in self.stdout:
+                if self.read_error is None:
+                    try:
+                        self.shim_output.add_line(line.decode('ascii'))
+                    except (TypeError, ValueError) as err: # UnicodeDecodeError is a ValueError
+                        self.read_error = err
+
+    def _read_stderr(self):
+        """Reader thread: collects stderr until the process closes it"""
+        with self.stderr:
+            self.stderr_chunks.append(self.stderr.read())
+
     def _kill(self, timeout):
         """Method called when timer expires"""
         del timeout # unused
@@ -79,6 +112,100 @@ class ShimProcess(subprocess.Popen):
         self.killed_flag = True
 
 
+class RecordCollector:
+    """Collects the records of a streaming receiver into a list, in the order they are received"""
+    def __init__(self):
+        self.records = []
+
+    def add(self, record):
+        """Add one record read from the shim output"""
+        self.records.append(record)
+
+    def result(self):
+        """Return the value the receiver would have written as its received value list"""
+        return self.records
+
+
+class ShimOutput:
+    """
+    Parses shim stdout a line at a time. Two formats are accepted: an AMQP type line followed by a single JSON
+    value, or (streaming mode) an AMQP type line followed by any number of JSON records and a summary line, which
+    is an object with the single member SUMMARY_KEY.
+    """
+    SUMMARY_KEY = 'qpidit.summary'
+    MAX_TEXT_LEN = 64 * 1024 # Output kept for error reports
+    _NO_VALUE = object()
+
+    def __init__(self, record_collector):
+        self.record_collector = record_collector
+        self.type_line = None
+        self.first_value = self._NO_VALUE # Held back until it is known whether this is streaming output
+        self.num_records = 0
+        self.summary = None
+        self.malformed_flag = False
+        self.text_parts = []
+        self.text_len = 0
+        self.num_lines = 0
+
+    def add_line(self, line):
+        """Add one line of shim output"""
+        self.num_lines += 1
+        if self.text_len < self.MAX_TEXT_LEN:
+            self.text_parts.append(line)
+            self.text_len += len(line)
+        line = line.rstrip('\n')
+        if self.type_line is None:
+            self.type_line = line
+            return
+        if self.summary is not None:
+            self.malformed_flag = True # Nothing may follow the summary
+            return
+        try:
+            value = json.loads(line)
+        except ValueError:
+            self.malformed_flag = True
+            return
+        if isinstance(value, dict) and self.SUMMARY_KEY in value:
+            self._add_first_value()
+            self.summary = value[self.SUMMARY_KEY]
+        elif self.first_value is self._NO_VALUE and self.num_records == 0:
+            self.first_value = value
+        else:
+            self._add_first_value()
+            self._add_record(value)
+
+    def empty(self):
+        """Return True if the shim wrote nothing"""
+        return self.num_lines == 0
+
+    def text(self):
+        """Return the shim output as a string, truncated if long"""
+        text = ''.join(self.text_parts)
+        return text if self.text_len < self.MAX_TEXT_LEN else text + '...'
+
+    def result(self):
+        """Return tuple (AMQP type, received value) from a complete output, otherwise the output as a string"""
+        if self.malformed_flag:
+            return self.text() # ERROR: return single string
+        if self.summary is not None:
+            if self.summary.get('records') != self.num_records:
+                return 'Summary of %s records, but %d records received\nstdout=%s' % \
+                       (self.summary.get('records'), self.num_records, self.text())
+            return (self.type_line, self.record_collector.result())
+        if self.first_value is not self._NO_VALUE and self.num_records == 0:
+            return (self.type_line, self.first_value)
+        return self.text() # ERROR: return single string
+
+    def _add_first_value(self):
+        if self.first_value is not self._NO_VALUE:
+            self._add_record(self.first_value)
+            self.first_value = self._NO_VALUE
+
+    def _add_record(self, value):
+        self.record_collector.add(value)
+        self.num_records += 1
+
+
 class Sender(ShimProcess):
     """Sender shim process"""
     def __init__(self, params, proc_name='Sender'):
@@ -86,15 +213,21 @@ class Sender(ShimProcess):
         super().__init__(params, proc_name)
 
 class Receiver(ShimProcess):
-    """Receiver shim process"""
-    def __init__(self, params, proc_name='Receiver'):
+    """Receiver shim process, passing each record of streaming output to record_collector as it arrives"""
+    def __init__(self, params, proc_name='Receiver', record_collector=None):
         #print('\n>>>RCVR>>> %s' % params)
-        super().__init__(params, proc_name)
+        super().__init__(params, proc_name, record_collector)
 
 class Shim:
     """Abstract shim class, parent of all shims."""
     NAME = ''
     JMS_CLIENT = False # Enables certain JMS-specific message checks
+    STREAM_RECEIVER_OPTION = None # Receiver option selecting streaming (NDJSON) output, if supported
+    SIZE_SWEEP_SUPPORTED = False # Large content shims accept --size-bytes and --repeat, and print benchmark stats
+    DECODE_COST_SUPPORTED = False # Large content receivers accept --decode-cost, and report it in their summary
+    PAYLOAD_FILE_SUPPORTED = False # Large content senders accept --payload-file and --payload-hugepages
+    LARGE_MESSAGE_SEND_SUPPORTED = False # Large content senders send 100 MB messages within the test timeout
+    LARGE_MESSAGE_RECEIVE_SUPPORTED = False # Large content receivers receive 100 MB messages within the test timeout
     def __init__(self, sender_shim, receiver_shim):
         self.sender_shim = sender_shim
         self.receiver_shim = receiver_shim
@@ -102,19 +235,30 @@ class Shim:
         self.receive_params = None
         self.use_shell_flag = False
 
-    def create_sender(self, broker_addr, queue_name, test_key, json_test_str):
-        """Create a new sender instance"""
+    def create_sender(self, broker_addr, queue_name, test_key, json_test_str, options=None):
+        """Create a new sender instance, passing any shim options after the fixed arguments"""
         args = []
         args.extend(self.send_params)
         args.extend([broker_addr, queue_name, test_key, json_test_str])
+        if options is not None:
+            args.extend(options)
         return Sender(args)
 
-    def create_receiver(self, broker_addr, queue_name, test_key, json_test_str):
-        """Create a new receiver instance"""
+    def create_receiver(self, broker_addr, queue_name, test_key, json_test_str, stream_flag=False, options=None,
+                        record_collector=None):
+        """
+        Create a new receiver instance, with streaming output if requested and supported by this shim, passing any
+        shim options after the fixed arguments. Its output is read from the start, streaming records going to
+        record_collector (by default a RecordCollector).
+        """
         args = []
         args.extend(self.receive_params)
         args.extend([broker_addr, queue_name, test_key, json_test_str])
-        return Receiver(args)
+        if stream_flag and self.STREAM_RECEIVER_OPTION is not None:
+            args.append(self.STREAM_RECEIVER_OPTION)
+        if options is not None:
+            args.extend(options)
+        return Receiver(args, record_collector=record_collector)
 
 
 class ProtonPython3Shim(Shim):
@@ -129,6 +273,11 @@ class ProtonPython3Shim(Shim):
 class ProtonCppShim(Shim):
     """Shim for qpid-proton C++ client"""
     NAME = 'ProtonCpp'
+    STREAM_RECEIVER_OPTION = '--stream'
+    SIZE_SWEEP_SUPPORTED = True
+    DECODE_COST_SUPPORTED = True
+    PAYLOAD_FILE_SUPPORTED = True
+    LARGE_MESSAGE_SEND_SUPPORTED = True # Streams messages in chunks. The receiver still buffers and decodes them whole.
     def __init__(self, sender_shim, receiver_shim):
         super().__init__(sender_shim, receiver_shim)
         self.send_params = [self.sender_shim]